@@ -0,0 +1,73 @@
+# Links the compression backend selected through LIBROMFS_COMPRESS_RESOURCES and LIBROMFS_COMPRESSION_CODEC into a target.
+# The generator and the library both need to end up with the same LIBROMFS_COMPRESSION_CODEC, the generated
+# resource file checks this with a static_assert.
+function(libromfs_configure_compression TARGET DESCRIPTION)
+    if (NOT LIBROMFS_COMPRESS_RESOURCES)
+        return()
+    endif ()
+
+    if (NOT LIBROMFS_COMPRESSION_CODEC OR LIBROMFS_COMPRESSION_CODEC STREQUAL "zlib")
+        find_package(ZLIB QUIET)
+        if (ZLIB_FOUND)
+            target_link_libraries(${TARGET} PRIVATE ZLIB::ZLIB)
+            target_compile_definitions(${TARGET} PRIVATE LIBROMFS_COMPRESS_RESOURCES=1 LIBROMFS_COMPRESSION_CODEC=1)
+        else()
+            message(WARNING "Requested ${DESCRIPTION} to be compressed but zlib is unavailable! Resources will NOT be compressed.")
+        endif()
+    elseif (LIBROMFS_COMPRESSION_CODEC STREQUAL "zstd")
+        find_package(PkgConfig QUIET)
+        if (PKG_CONFIG_FOUND)
+            pkg_check_modules(LIBROMFS_ZSTD QUIET IMPORTED_TARGET libzstd)
+        endif()
+
+        if (LIBROMFS_ZSTD_FOUND)
+            target_link_libraries(${TARGET} PRIVATE PkgConfig::LIBROMFS_ZSTD)
+            target_compile_definitions(${TARGET} PRIVATE LIBROMFS_COMPRESS_RESOURCES=1 LIBROMFS_COMPRESSION_CODEC=2)
+        else()
+            message(WARNING "Requested ${DESCRIPTION} to be compressed with zstd but libzstd is unavailable! Resources will NOT be compressed.")
+        endif()
+    elseif (LIBROMFS_COMPRESSION_CODEC STREQUAL "lz4")
+        find_package(PkgConfig QUIET)
+        if (PKG_CONFIG_FOUND)
+            pkg_check_modules(LIBROMFS_LZ4 QUIET IMPORTED_TARGET liblz4)
+        endif()
+
+        if (LIBROMFS_LZ4_FOUND)
+            target_link_libraries(${TARGET} PRIVATE PkgConfig::LIBROMFS_LZ4)
+            target_compile_definitions(${TARGET} PRIVATE LIBROMFS_COMPRESS_RESOURCES=1 LIBROMFS_COMPRESSION_CODEC=3)
+        else()
+            message(WARNING "Requested ${DESCRIPTION} to be compressed with lz4 but liblz4 is unavailable! Resources will NOT be compressed.")
+        endif()
+    else()
+        message(FATAL_ERROR "Unknown LIBROMFS_COMPRESSION_CODEC '${LIBROMFS_COMPRESSION_CODEC}', expected one of: zlib, zstd, lz4")
+    endif()
+endfunction()
+
+# Swaps in libdeflate for decompressing whole zlib compressed resources in a single call through LIBROMFS_USE_LIBDEFLATE.
+# zlib stays linked for streaming, libdeflate can only decompress entire buffers. Only the library needs this,
+# the generator keeps compressing with zlib as the on-disk format doesn't change.
+function(libromfs_configure_inflate TARGET)
+    if (NOT LIBROMFS_COMPRESS_RESOURCES OR NOT LIBROMFS_USE_LIBDEFLATE)
+        return()
+    endif ()
+
+    if (LIBROMFS_COMPRESSION_CODEC AND NOT LIBROMFS_COMPRESSION_CODEC STREQUAL "zlib")
+        message(WARNING "LIBROMFS_USE_LIBDEFLATE only applies to the zlib codec and is ignored for ${LIBROMFS_COMPRESSION_CODEC}")
+        return()
+    endif ()
+
+    find_package(PkgConfig QUIET)
+    if (PKG_CONFIG_FOUND)
+        pkg_check_modules(LIBROMFS_LIBDEFLATE QUIET IMPORTED_TARGET libdeflate)
+    endif()
+
+    if (LIBROMFS_LIBDEFLATE_FOUND)
+        target_link_libraries(${TARGET} PRIVATE PkgConfig::LIBROMFS_LIBDEFLATE)
+        target_compile_definitions(${TARGET} PRIVATE LIBROMFS_USE_LIBDEFLATE=1)
+        if (NOT LIBROMFS_VERIFY_CHECKSUMS)
+            target_compile_definitions(${TARGET} PRIVATE LIBROMFS_SKIP_CHECKSUMS=1)
+        endif ()
+    else()
+        message(WARNING "Requested libdeflate but it is unavailable! Falling back to zlib's inflate().")
+    endif()
+endfunction()
@@ -1,4 +1,16 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -11,9 +23,25 @@ namespace fs = boost::filesystem;
 namespace fs = std::filesystem;
 #endif
 
+#define LIBROMFS_CODEC_ZLIB 1
+#define LIBROMFS_CODEC_ZSTD 2
+#define LIBROMFS_CODEC_LZ4 3
+
+#if !defined(LIBROMFS_COMPRESSION_CODEC)
+#define LIBROMFS_COMPRESSION_CODEC LIBROMFS_CODEC_ZLIB
+#endif
+
 #if defined(LIBROMFS_COMPRESS_RESOURCES)
+#if LIBROMFS_COMPRESSION_CODEC == LIBROMFS_CODEC_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#elif LIBROMFS_COMPRESSION_CODEC == LIBROMFS_CODEC_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#else
 #include <zlib.h>
 #endif
+#endif
 
 namespace
 {
@@ -162,21 +190,30 @@ namespace
         return true;
     }
 
-    std::vector<std::string> parseIgnoreFile(const fs::path &resourcePath)
+    struct PatternLine
+    {
+        std::size_t number;
+        std::string text;
+    };
+
+    // Reads the non-empty, non-comment lines of a .gitignore style file along with their line numbers
+    std::vector<PatternLine> readPatternLines(const fs::path &path)
     {
-        std::vector<std::string> patterns;
-        fs::path ignoreFile = resourcePath / ".romfsignore";
+        std::vector<PatternLine> lines;
 
-        if (!fs::exists(ignoreFile))
-            return patterns;
+        if (!fs::exists(path))
+            return lines;
 
-        std::ifstream file(ignoreFile.string());
+        std::ifstream file(path.string());
         if (!file.is_open())
-            return patterns;
+            return lines;
 
         std::string line;
+        std::size_t number = 0;
         while (std::getline(file, line))
         {
+            number++;
+
             // Trim whitespace
             size_t start = line.find_first_not_of(" \t\r\n");
             size_t end = line.find_last_not_of(" \t\r\n");
@@ -190,22 +227,938 @@ namespace
             if (line.empty() || line[0] == '#')
                 continue;
 
-            patterns.push_back(line);
+            lines.push_back({ number, line });
+        }
+
+        return lines;
+    }
+
+    std::vector<std::string> readPatternFile(const fs::path &path)
+    {
+        std::vector<std::string> lines;
+        for (auto &line : readPatternLines(path))
+            lines.push_back(std::move(line.text));
+
+        return lines;
+    }
+
+    std::vector<std::string> parseIgnoreFile(const fs::path &resourcePath)
+    {
+        return readPatternFile(resourcePath / ".romfsignore");
+    }
+
+    struct CompressionPolicy
+    {
+        enum class Mode
+        {
+            Store,
+            Compress,
+            Auto
+        };
+
+        std::string pattern;
+        Mode mode = Mode::Auto;
+
+        // In Auto mode, resources are only kept compressed if that shrinks them to at most this fraction of their size
+        double threshold = 0.9;
+    };
+
+    // Parses the .romfscompress file. Every line is "<pattern> <policy>" where policy is one of
+    //   store          embed the file uncompressed
+    //   compress       always compress the file
+    //   auto[:ratio]   compress the file if that shrinks it to at most ratio of its size, 0.9 by default
+    // When multiple patterns match a file, the last one wins. Fails on a ratio outside of (0, 1]
+    bool parseCompressionFile(const fs::path &resourcePath, std::vector<CompressionPolicy> &policies)
+    {
+        const auto path = resourcePath / ".romfscompress";
+        for (const auto &[number, line] : readPatternLines(path))
+        {
+            auto separator = line.find_last_of(" \t");
+            if (separator == std::string::npos)
+            {
+                std::printf("[libromfs] Ignoring invalid compression policy: %s\n", line.c_str());
+                continue;
+            }
+
+            CompressionPolicy policy;
+            policy.pattern = line.substr(0, line.find_last_not_of(" \t", separator) + 1);
+
+            auto mode = line.substr(separator + 1);
+            if (mode == "store")
+                policy.mode = CompressionPolicy::Mode::Store;
+            else if (mode == "compress")
+                policy.mode = CompressionPolicy::Mode::Compress;
+            else if (mode == "auto")
+                policy.mode = CompressionPolicy::Mode::Auto;
+            else if (mode.rfind("auto:", 0) == 0)
+            {
+                const char *ratio = mode.c_str() + 5;
+                char *ratioEnd = nullptr;
+
+                policy.mode = CompressionPolicy::Mode::Auto;
+                policy.threshold = std::strtod(ratio, &ratioEnd);
+                if (ratioEnd == ratio || *ratioEnd != '\0' || !(policy.threshold > 0.0 && policy.threshold <= 1.0))
+                {
+                    std::printf("[libromfs] %s:%zu: Invalid compression ratio '%s', expected a number greater than 0 and at most 1\n", path.string().c_str(), number, ratio);
+                    return false;
+                }
+            }
+            else
+            {
+                std::printf("[libromfs] Ignoring invalid compression policy: %s\n", line.c_str());
+                continue;
+            }
+
+            policies.push_back(policy);
+        }
+
+        return true;
+    }
+
+#if defined(LIBROMFS_COMPRESS_RESOURCES)
+    CompressionPolicy findCompressionPolicy(const fs::path &filePath, const std::vector<CompressionPolicy> &policies)
+    {
+        auto pathStr = filePath.generic_string();
+
+        CompressionPolicy result;
+        for (const auto &policy : policies)
+        {
+            if (matchPattern(pathStr, policy.pattern))
+                result = policy;
+        }
+
+        return result;
+    }
+#endif
+
+    // FNV-1a over the path bytes, must be kept in sync with the lookup in lib/source/romfs.cpp
+    std::uint64_t hashPath(std::string_view path)
+    {
+        std::uint64_t hash = 0xCBF29CE484222325;
+        for (char c : path)
+        {
+            hash ^= static_cast<std::uint8_t>(c);
+            hash *= 0x100000001B3;
+        }
+        return hash;
+    }
+
+    // Re-mixes a path hash with a bucket seed to pick its final slot
+    std::uint64_t mixSeed(std::uint64_t hash, std::uint32_t seed)
+    {
+        hash ^= seed * 0x9E3779B97F4A7C15;
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCD;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB93FE1A85EC9;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    struct PerfectHash
+    {
+        std::vector<std::int32_t> seeds;
+        std::vector<std::uint32_t> slots;
+    };
+
+    // Builds a minimal perfect hash (hash and displace) over the given keys.
+    // Every key hashes into one of N buckets. Buckets holding more than one key get a seed that
+    // scatters their keys into free slots, single key buckets store their slot directly as -(slot + 1).
+    // slots[] maps every slot back to the index of the key that occupies it.
+    bool buildPerfectHash(const std::vector<std::string> &keys, PerfectHash &result)
+    {
+        const auto count = keys.size();
+        result.seeds.assign(count, 0);
+        result.slots.assign(count, std::numeric_limits<std::uint32_t>::max());
+
+        if (count == 0)
+            return true;
+
+        std::vector<std::uint64_t> hashes;
+        std::vector<std::vector<std::uint32_t>> buckets(count);
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            hashes.push_back(hashPath(keys[i]));
+            buckets[hashes.back() % count].push_back(i);
+        }
+
+        std::vector<std::uint32_t> bucketOrder(count);
+        for (std::uint32_t i = 0; i < count; i++)
+            bucketOrder[i] = i;
+        std::stable_sort(bucketOrder.begin(), bucketOrder.end(), [&](std::uint32_t a, std::uint32_t b)
+                         { return buckets[a].size() > buckets[b].size(); });
+
+        std::vector<std::uint64_t> candidates;
+        std::size_t bucketIndex = 0;
+        for (; bucketIndex < count && buckets[bucketOrder[bucketIndex]].size() > 1; bucketIndex++)
+        {
+            const auto &bucket = buckets[bucketOrder[bucketIndex]];
+
+            bool placed = false;
+            for (std::uint32_t seed = 1; seed < (1U << 24) && !placed; seed++)
+            {
+                candidates.clear();
+                for (auto key : bucket)
+                {
+                    auto slot = mixSeed(hashes[key], seed) % count;
+                    if (result.slots[slot] != std::numeric_limits<std::uint32_t>::max() || std::find(candidates.begin(), candidates.end(), slot) != candidates.end())
+                        break;
+                    candidates.push_back(slot);
+                }
+
+                if (candidates.size() != bucket.size())
+                    continue;
+
+                for (std::size_t i = 0; i < bucket.size(); i++)
+                    result.slots[candidates[i]] = bucket[i];
+                result.seeds[bucketOrder[bucketIndex]] = static_cast<std::int32_t>(seed);
+                placed = true;
+            }
+
+            if (!placed)
+                return false;
+        }
+
+        std::size_t freeSlot = 0;
+        for (; bucketIndex < count && buckets[bucketOrder[bucketIndex]].size() == 1; bucketIndex++)
+        {
+            while (result.slots[freeSlot] != std::numeric_limits<std::uint32_t>::max())
+                freeSlot++;
+
+            result.slots[freeSlot] = buckets[bucketOrder[bucketIndex]].front();
+            result.seeds[bucketOrder[bucketIndex]] = -static_cast<std::int32_t>(freeSlot) - 1;
+        }
+
+        return true;
+    }
+
+    void writeLookupTable(std::ostream &outputFile, const std::string &functionPrefix, const PerfectHash &perfectHash)
+    {
+        outputFile << "ROMFS_VISIBILITY nonstd::span<const std::int32_t> " << functionPrefix << "_hash_seeds() {\n";
+        outputFile << "    static constexpr std::array<std::int32_t, " << perfectHash.seeds.size() << "> seeds = {{\n";
+        outputFile << "        ";
+        for (auto seed : perfectHash.seeds)
+        {
+            outputFile << seed << ",";
+        }
+        outputFile << "\n    }};";
+
+        outputFile << "\n\n    return seeds;\n";
+        outputFile << "}\n\n";
+
+        outputFile << "ROMFS_VISIBILITY nonstd::span<const std::uint32_t> " << functionPrefix << "_hash_slots() {\n";
+        outputFile << "    static constexpr std::array<std::uint32_t, " << perfectHash.slots.size() << "> slots = {{\n";
+        outputFile << "        ";
+        for (auto slot : perfectHash.slots)
+        {
+            outputFile << slot << ",";
+        }
+        outputFile << "\n    }};";
+
+        outputFile << "\n\n    return slots;\n";
+        outputFile << "}\n\n";
+    }
+
+    std::vector<std::string_view> splitPath(std::string_view path)
+    {
+        std::vector<std::string_view> components;
+        while (!path.empty())
+        {
+            auto separator = path.find('/');
+            components.push_back(path.substr(0, separator));
+            path = separator == std::string_view::npos ? std::string_view() : path.substr(separator + 1);
+        }
+        return components;
+    }
+
+    std::string parentPath(const std::string &path)
+    {
+        auto separator = path.rfind('/');
+        return separator == std::string::npos ? std::string() : path.substr(0, separator);
+    }
+
+    // Orders file paths so that the files of every directory are contiguous and directly followed by
+    // the files of its subdirectories, depth first. The directory table relies on this layout.
+    bool filePreorderLess(const std::string &lhs, const std::string &rhs)
+    {
+        auto lhsComponents = splitPath(lhs);
+        auto rhsComponents = splitPath(rhs);
+
+        for (std::size_t i = 0; i < lhsComponents.size() && i < rhsComponents.size(); i++)
+        {
+            if (lhsComponents[i] == rhsComponents[i])
+                continue;
+
+            bool lhsIsFile = i == lhsComponents.size() - 1;
+            bool rhsIsFile = i == rhsComponents.size() - 1;
+            if (lhsIsFile != rhsIsFile)
+                return lhsIsFile;
+
+            return lhsComponents[i] < rhsComponents[i];
+        }
+
+        return lhsComponents.size() < rhsComponents.size();
+    }
+
+    bool isAncestorPath(const std::string &ancestor, const std::string &path)
+    {
+        return ancestor.empty() || (path.size() > ancestor.size() && path.compare(0, ancestor.size(), ancestor) == 0 && path[ancestor.size()] == '/');
+    }
+
+    bool directoryPreorderLess(const std::string &lhs, const std::string &rhs)
+    {
+        auto lhsComponents = splitPath(lhs);
+        auto rhsComponents = splitPath(rhs);
+        return std::lexicographical_compare(lhsComponents.begin(), lhsComponents.end(), rhsComponents.begin(), rhsComponents.end());
+    }
+
+    std::vector<std::uint8_t> readFile(const fs::path &path, std::size_t maxSize = std::numeric_limits<std::size_t>::max())
+    {
+        std::vector<std::uint8_t> data;
+        data.resize(std::min<std::size_t>(fs::file_size(path), maxSize));
+
+        auto file = std::fopen(path.string().c_str(), "rb");
+        data.resize(std::fread(data.data(), 1, data.size(), file));
+        std::fclose(file);
+
+        return data;
+    }
+
+    // 64 bit FNV-1a, identifies data across generator runs
+    std::uint64_t hashBytes(const std::uint8_t *data, std::size_t size, std::uint64_t hash = 0xCBF29CE484222325)
+    {
+        for (std::size_t i = 0; i < size; i++)
+        {
+            hash ^= data[i];
+            hash *= 0x100000001B3;
+        }
+
+        return hash;
+    }
+
+    std::uint64_t hashBytes(const std::vector<std::uint8_t> &data, std::uint64_t hash = 0xCBF29CE484222325)
+    {
+        return hashBytes(data.data(), data.size(), hash);
+    }
+
+    std::string toHex(std::uint64_t value)
+    {
+        char buffer[17];
+        std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+        return buffer;
+    }
+
+    // Only writes files whose content actually changed, so the build system doesn't recompile anything for the others
+    void writeIfChanged(const fs::path &path, std::string_view content)
+    {
+        if (fs::exists(path) && fs::file_size(path) == content.size())
+        {
+            auto existing = readFile(path);
+            if (std::equal(existing.begin(), existing.end(), content.begin(), content.end(), [](std::uint8_t a, char b) { return a == static_cast<std::uint8_t>(b); }))
+                return;
+        }
+
+        // Written next to it first and renamed into place, so an interrupted run never leaves a partially written file behind
+        auto temporaryPath = path;
+        temporaryPath += ".tmp";
+        {
+            std::ofstream file(temporaryPath.string(), std::ios::binary | std::ios::trunc);
+            file.write(content.data(), static_cast<std::streamsize>(content.size()));
+            if (!file.flush())
+            {
+                file.close();
+                std::remove(temporaryPath.string().c_str());
+                return;
+            }
+        }
+
+        fs::rename(temporaryPath, path);
+    }
+
+#if defined(LIBROMFS_COMPRESS_RESOURCES) && LIBROMFS_COMPRESSION_CODEC == LIBROMFS_CODEC_ZSTD
+    // Trains one dictionary over the beginning of every resource. Many small, similar files compress
+    // poorly on their own since every frame starts without any history, a shared dictionary provides it.
+    std::vector<std::uint8_t> trainDictionary(const std::vector<fs::path> &files)
+    {
+        constexpr std::size_t MaxSampleSize = 128 * 1024;
+        constexpr std::size_t MaxDictionarySize = 110 * 1024;
+
+        std::vector<std::uint8_t> samples;
+        std::vector<std::size_t> sampleSizes;
+        for (const auto &file : files)
+        {
+            auto data = readFile(file, MaxSampleSize);
+            if (data.empty())
+                continue;
+
+            samples.insert(samples.end(), data.begin(), data.end());
+            sampleSizes.push_back(data.size());
+        }
+
+        // The trainer needs a reasonable amount of samples, otherwise it's better to go without a dictionary
+        const auto dictionarySize = std::min(MaxDictionarySize, samples.size() / 10);
+        if (sampleSizes.size() < 8 || dictionarySize < 256)
+            return {};
+
+        std::vector<std::uint8_t> dictionary(dictionarySize);
+        auto result = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), samples.data(), sampleSizes.data(), static_cast<unsigned>(sampleSizes.size()));
+        if (ZDICT_isError(result))
+        {
+            std::printf("[libromfs] Not using a compression dictionary: %s\n", ZDICT_getErrorName(result));
+            return {};
+        }
+
+        dictionary.resize(result);
+        return dictionary;
+    }
+
+    // Retraining the dictionary whenever any resource changes would change every compressed resource along with it,
+    // so the one of the last run is kept for as long as the same files are bundled. Deleting it forces retraining
+    std::vector<std::uint8_t> loadOrTrainDictionary(const std::vector<fs::path> &files, const std::vector<fs::path> &relativePaths, const fs::path &cacheDirectory)
+    {
+        std::vector<std::string> keys;
+        for (const auto &relativePath : relativePaths)
+            keys.push_back(relativePath.generic_string());
+        std::sort(keys.begin(), keys.end());
+
+        auto fileSetHash = hashBytes(nullptr, 0);
+        for (const auto &key : keys)
+            fileSetHash = hashBytes(reinterpret_cast<const std::uint8_t *>(key.c_str()), key.size() + 1, fileSetHash);
+
+        const auto dictionaryPath = cacheDirectory / ("dictionary_" + toHex(fileSetHash) + ".dict");
+        if (fs::exists(dictionaryPath))
+        {
+            std::printf("[libromfs] Reusing the compression dictionary of the last run\n");
+            return readFile(dictionaryPath);
+        }
+
+        auto dictionary = trainDictionary(files);
+
+        fs::create_directories(cacheDirectory);
+        for (const auto &entry : fs::directory_iterator(cacheDirectory))
+        {
+            if (entry.path().extension() == ".dict")
+                fs::remove(entry.path());
+        }
+        writeIfChanged(dictionaryPath, std::string_view(reinterpret_cast<const char *>(dictionary.data()), dictionary.size()));
+
+        return dictionary;
+    }
+#endif
+
+    class Compressor
+    {
+    public:
+#if defined(LIBROMFS_COMPRESS_RESOURCES) && LIBROMFS_COMPRESSION_CODEC == LIBROMFS_CODEC_ZSTD
+        static constexpr int CompressionLevel = 19;
+
+        explicit Compressor(std::vector<std::uint8_t> dictionary) : m_dictionary(std::move(dictionary))
+        {
+            m_context = ZSTD_createCCtx();
+            if (!m_dictionary.empty())
+                m_compressionDictionary = ZSTD_createCDict(m_dictionary.data(), m_dictionary.size(), CompressionLevel);
+        }
+
+        ~Compressor()
+        {
+            ZSTD_freeCDict(m_compressionDictionary);
+            ZSTD_freeCCtx(m_context);
+        }
+
+        Compressor(const Compressor &) = delete;
+        Compressor &operator=(const Compressor &) = delete;
+
+        const std::vector<std::uint8_t> &dictionary() const
+        {
+            return m_dictionary;
+        }
+
+        bool compress(const std::vector<std::uint8_t> &input, std::vector<std::uint8_t> &output)
+        {
+            output.resize(ZSTD_compressBound(input.size()));
+
+            std::size_t result;
+            if (m_compressionDictionary != nullptr)
+                result = ZSTD_compress_usingCDict(m_context, output.data(), output.size(), input.data(), input.size(), m_compressionDictionary);
+            else
+                result = ZSTD_compressCCtx(m_context, output.data(), output.size(), input.data(), input.size(), CompressionLevel);
+
+            if (ZSTD_isError(result))
+                return false;
+
+            output.resize(result);
+            return true;
+        }
+
+    private:
+        std::vector<std::uint8_t> m_dictionary;
+        ZSTD_CCtx *m_context = nullptr;
+        ZSTD_CDict *m_compressionDictionary = nullptr;
+#elif defined(LIBROMFS_COMPRESS_RESOURCES) && LIBROMFS_COMPRESSION_CODEC == LIBROMFS_CODEC_LZ4
+        // Raw LZ4 blocks, the library knows the decompressed size of every resource so no frame is needed
+        bool compress(const std::vector<std::uint8_t> &input, std::vector<std::uint8_t> &output)
+        {
+            if (input.size() > LZ4_MAX_INPUT_SIZE)
+                return false;
+
+            output.resize(LZ4_compressBound(static_cast<int>(input.size())));
+
+            // LZ4 doesn't accept a null source, not even for empty input
+            const std::uint8_t empty = 0;
+            auto source = input.empty() ? &empty : input.data();
+
+            auto result = LZ4_compress_HC(reinterpret_cast<const char *>(source), reinterpret_cast<char *>(output.data()), static_cast<int>(input.size()), static_cast<int>(output.size()), LZ4HC_CLEVEL_MAX);
+            if (result <= 0)
+                return false;
+
+            output.resize(result);
+            return true;
+        }
+#elif defined(LIBROMFS_COMPRESS_RESOURCES)
+        bool compress(const std::vector<std::uint8_t> &input, std::vector<std::uint8_t> &output)
+        {
+            z_stream stream;
+            stream.zalloc = Z_NULL;
+            stream.zfree = Z_NULL;
+            stream.opaque = Z_NULL;
+            stream.avail_in = input.size();
+            stream.next_in = const_cast<std::uint8_t *>(input.data());
+
+            if (deflateInit(&stream, Z_BEST_COMPRESSION) != Z_OK)
+                return false;
+
+            // Allocate the worst case compressed size
+            output.resize(deflateBound(&stream, input.size()));
+
+            stream.avail_out = output.size();
+            stream.next_out = output.data();
+
+            // Perform the compression
+            if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+            {
+                deflateEnd(&stream);
+                return false;
+            }
+
+            // Resize the output buffer to the actual size
+            output.resize(stream.total_out);
+
+            // Clean up
+            deflateEnd(&stream);
+            return true;
+        }
+#endif
+    };
+
+#if defined(LIBROMFS_COMPRESS_RESOURCES)
+    // Compresses input in independent chunks of chunkSize bytes so the library can decompress any range of
+    // a resource without touching the rest of it. chunkOffsets receives where every chunk starts in output,
+    // followed by the total size. Resources that fit into a single chunk don't need any offsets
+    bool compressChunked(Compressor &compressor, const std::vector<std::uint8_t> &input, std::size_t chunkSize, std::vector<std::uint8_t> &output, std::vector<std::uint64_t> &chunkOffsets)
+    {
+        output.clear();
+        chunkOffsets.clear();
+
+        if (chunkSize == 0 || input.size() <= chunkSize)
+            return compressor.compress(input, output);
+
+        std::vector<std::uint8_t> chunk, compressedChunk;
+        for (std::size_t offset = 0; offset < input.size(); offset += chunkSize)
+        {
+            chunk.assign(input.begin() + offset, input.begin() + std::min(offset + chunkSize, input.size()));
+            if (!compressor.compress(chunk, compressedChunk))
+                return false;
+
+            chunkOffsets.push_back(output.size());
+            output.insert(output.end(), compressedChunk.begin(), compressedChunk.end());
+        }
+        chunkOffsets.push_back(output.size());
+
+        return true;
+    }
+
+    // Compressed data of earlier generator runs, so only resources that changed since then need to be compressed again.
+    // Entries are keyed by a hash of the uncompressed data and of everything else influencing the compressed result.
+    // The manifest lists the entries used by the latest run together with the resource they belong to, all others get removed
+    class CompressionCache
+    {
+    public:
+        CompressionCache(fs::path directory, std::uint64_t settingsHash) : m_directory(std::move(directory)), m_settingsHash(settingsHash)
+        {
+            fs::create_directories(m_directory);
+
+            std::ifstream manifest((m_directory / "manifest").string());
+            std::string key, name;
+            while (manifest >> key && std::getline(manifest >> std::ws, name))
+                m_previousEntries.insert(key);
+        }
+
+        // Same as compressChunked(), but reuses the result of an earlier run if there is one
+        bool compress(Compressor &compressor, const std::string &name, const std::vector<std::uint8_t> &input, std::size_t chunkSize, std::vector<std::uint8_t> &output, std::vector<std::uint64_t> &chunkOffsets)
+        {
+            const auto key = toHex(hashBytes(input, m_settingsHash)) + toHex(input.size());
+            m_entries[key] = name;
+
+            if (m_previousEntries.contains(key) && load(key, output, chunkOffsets))
+            {
+                m_reused++;
+                return true;
+            }
+
+            if (!compressChunked(compressor, input, chunkSize, output, chunkOffsets))
+                return false;
+
+            store(key, output, chunkOffsets);
+            return true;
+        }
+
+        // Writes the manifest and drops everything the latest run didn't use
+        void finish()
+        {
+            std::string manifest;
+            for (const auto &[key, name] : m_entries)
+                manifest += key + " " + name + "\n";
+            writeIfChanged(m_directory / "manifest", manifest);
+
+            for (const auto &entry : fs::directory_iterator(m_directory))
+            {
+                if ((entry.path().extension() == ".bin" && !m_entries.contains(entry.path().stem().string())) || entry.path().extension() == ".tmp")
+                    fs::remove(entry.path());
+            }
+
+            std::printf("[libromfs] Reused %zu of %zu compressed resources\n", m_reused, m_entries.size());
+        }
+
+    private:
+        static std::uint64_t checksum(const std::uint64_t *chunkOffsets, std::size_t count, const std::uint8_t *data, std::size_t size)
+        {
+            return hashBytes(data, size, hashBytes(reinterpret_cast<const std::uint8_t *>(chunkOffsets), count * sizeof(std::uint64_t)));
+        }
+
+        // Entries hold the number of chunk offsets, a checksum of everything that follows, the offsets and then the compressed data.
+        // Entries that are damaged or come from an older version of the generator are simply compressed again
+        bool load(const std::string &key, std::vector<std::uint8_t> &output, std::vector<std::uint64_t> &chunkOffsets) const
+        {
+            const auto path = m_directory / (key + ".bin");
+            if (!fs::exists(path))
+                return false;
+            auto data = readFile(path);
+
+            std::uint64_t count = 0, expectedChecksum = 0;
+            if (data.size() < sizeof(count) + sizeof(expectedChecksum))
+                return false;
+            std::memcpy(&count, data.data(), sizeof(count));
+            std::memcpy(&expectedChecksum, data.data() + sizeof(count), sizeof(expectedChecksum));
+
+            const auto headerSize = sizeof(count) + sizeof(expectedChecksum) + count * sizeof(std::uint64_t);
+            if (count > data.size() / sizeof(std::uint64_t) || data.size() < headerSize)
+                return false;
+
+            std::vector<std::uint64_t> offsets(count);
+            std::memcpy(offsets.data(), data.data() + sizeof(count) + sizeof(expectedChecksum), count * sizeof(std::uint64_t));
+            if (checksum(offsets.data(), offsets.size(), data.data() + headerSize, data.size() - headerSize) != expectedChecksum)
+                return false;
+
+            chunkOffsets = std::move(offsets);
+            output.assign(data.begin() + headerSize, data.end());
+
+            return true;
+        }
+
+        void store(const std::string &key, const std::vector<std::uint8_t> &output, const std::vector<std::uint64_t> &chunkOffsets) const
+        {
+            const std::uint64_t count = chunkOffsets.size();
+            const std::uint64_t entryChecksum = checksum(chunkOffsets.data(), chunkOffsets.size(), output.data(), output.size());
+
+            std::string entry;
+            entry.append(reinterpret_cast<const char *>(&count), sizeof(count));
+            entry.append(reinterpret_cast<const char *>(&entryChecksum), sizeof(entryChecksum));
+            entry.append(reinterpret_cast<const char *>(chunkOffsets.data()), count * sizeof(std::uint64_t));
+            entry.append(reinterpret_cast<const char *>(output.data()), output.size());
+
+            writeIfChanged(m_directory / (key + ".bin"), entry);
         }
 
-        return patterns;
+        fs::path m_directory;
+        std::uint64_t m_settingsHash;
+        std::set<std::string> m_previousEntries;
+        std::map<std::string, std::string> m_entries;
+        std::size_t m_reused = 0;
+    };
+#endif
+
+    // How the bytes of resources end up in the generated source
+    enum class PayloadMode
+    {
+        // Decimal initializer lists, works everywhere but is slow to compile for large resources
+        Array,
+        // Preprocessor #embed of a file written next to the generated source, needs C23 / C++26 support
+        Embed,
+        // Assembler .incbin of a file written next to the generated source, needs a GNU compatible assembler
+        Incbin
+    };
+
+    // Emits an array named name holding bytes, in a way that can be used like a std::array in the generated code.
+    // The array starts at a multiple of alignment, which has to be a power of two. External arrays can be used
+    // from other generated files through writePayloadDeclaration(). Returns the payload file used, if any
+    fs::path writePayload(std::ostream &outputFile, PayloadMode mode, const std::string &name, const std::vector<std::uint8_t> &bytes, std::size_t alignment = 16, bool external = false)
+    {
+        const auto alignas_ = alignment > 16 ? "alignas(" + std::to_string(alignment) + ") " : std::string();
+        const auto storage = external ? "ROMFS_VISIBILITY extern const" : "static constexpr";
+
+        if (mode == PayloadMode::Array)
+        {
+            outputFile << alignas_ << storage << " std::array<std::uint8_t, " << bytes.size() << "> " << name << " = {\n";
+            outputFile << "    ";
+
+            for (auto byte : bytes)
+            {
+                outputFile << static_cast<std::uint32_t>(byte) << ",";
+            }
+
+            outputFile << " };\n\n";
+            return {};
+        }
+
+        // The payload files live next to the generated source. Build systems don't notice when the data behind an
+        // .incbin changes, so the name changes along with the content and the source referencing it has to be recompiled
+        const auto fileName = name + "_" + toHex(hashBytes(bytes)) + ".bin";
+        const auto payloadPath = fs::absolute(fs::path("libromfs_payload") / fileName);
+        fs::create_directories(payloadPath.parent_path());
+        writeIfChanged(payloadPath, { reinterpret_cast<const char *>(bytes.data()), bytes.size() });
+
+        if (mode == PayloadMode::Embed)
+        {
+            outputFile << alignas_ << storage << " std::array<std::uint8_t, " << bytes.size() << "> " << name << " = {\n";
+            outputFile << "#embed \"libromfs_payload/" << fileName << "\"\n";
+            outputFile << "};\n\n";
+            return payloadPath;
+        }
+
+        // Read-only data, the library never writes to embedded resources. The compiler doesn't know about the section
+        // switch, so it has to be undone for whatever the compiler emits next
+        const auto path = replace(replace(payloadPath.string(), "\\", "\\\\"), "\"", "\\\"");
+        outputFile << "extern \"C\" const std::array<std::uint8_t, " << bytes.size() << "> " << name << ";\n";
+        outputFile << "__asm__(\n";
+        outputFile << "#if defined(__APPLE__)\n";
+        outputFile << "    \".pushsection __DATA,__const\\n\"\n";
+        outputFile << "    \".p2align " << std::countr_zero(std::max<std::size_t>(alignment, 16)) << "\\n\"\n";
+        outputFile << "    \".globl _" << name << "\\n\"\n";
+        outputFile << "    \".private_extern _" << name << "\\n\"\n";
+        outputFile << "    \"_" << name << ":\\n\"\n";
+        outputFile << "#elif defined(_WIN32)\n";
+        outputFile << "    \".pushsection .rdata,\\\"dr\\\"\\n\"\n";
+        outputFile << "    \".p2align " << std::countr_zero(std::max<std::size_t>(alignment, 16)) << "\\n\"\n";
+        outputFile << "    \".globl " << name << "\\n\"\n";
+        outputFile << "    \"" << name << ":\\n\"\n";
+        outputFile << "#else\n";
+        outputFile << "    \".pushsection .rodata\\n\"\n";
+        outputFile << "    \".p2align " << std::countr_zero(std::max<std::size_t>(alignment, 16)) << "\\n\"\n";
+        outputFile << "    \".globl " << name << "\\n\"\n";
+        outputFile << "    \".hidden " << name << "\\n\"\n";
+        outputFile << "    \".type " << name << ", %object\\n\"\n";
+        outputFile << "    \".size " << name << ", " << bytes.size() << "\\n\"\n";
+        outputFile << "    \"" << name << ":\\n\"\n";
+        outputFile << "#endif\n";
+        outputFile << "    \".incbin \\\"" << path << "\\\"\\n\"\n";
+        outputFile << "    \".popsection\\n\"\n";
+        outputFile << ");\n\n";
+
+        return payloadPath;
+    }
+
+    // Makes an external array written by writePayload() into another generated file usable in this one
+    void writePayloadDeclaration(std::ostream &outputFile, PayloadMode mode, const std::string &name, std::size_t size)
+    {
+        outputFile << "extern " << (mode == PayloadMode::Incbin ? "\"C\" " : "") << "const std::array<std::uint8_t, " << size << "> " << name << ";\n";
     }
 
+    // Places the data of every resource and solid block either into an array of its own or, with a non zero
+    // alignment, all of it into a single blob where each of them starts at a multiple of alignment.
+    // With shard files, the arrays are spread over them once everything has been added, so they can be compiled in parallel
+    class PayloadLayout
+    {
+    public:
+        PayloadLayout(std::ostream &outputFile, std::vector<std::ostringstream> &shardFiles, PayloadMode mode, std::string blobName, std::size_t alignment)
+            : m_outputFile(outputFile), m_shardFiles(shardFiles), m_mode(mode), m_blobName(std::move(blobName)), m_alignment(alignment) {}
+
+        void add(const std::string &name, const std::vector<std::uint8_t> &bytes)
+        {
+            if (m_alignment == 0)
+            {
+                write(name, bytes, 16);
+                return;
+            }
+
+            m_blob.resize((m_blob.size() + m_alignment - 1) / m_alignment * m_alignment, 0x00);
+            m_entries[name] = { m_blob.size(), bytes.size() };
+            m_blob.insert(m_blob.end(), bytes.begin(), bytes.end());
+        }
+
+        // Emits the blob and the shards and removes payload files of earlier runs, has to be called once everything
+        // has been added and before anything refers to it
+        void finish()
+        {
+            if (m_alignment != 0 && !m_blob.empty())
+            {
+                std::printf("[libromfs] Writing %zu bytes of resource data aligned to %zu bytes\n", m_blob.size(), m_alignment);
+                write(m_blobName, m_blob, m_alignment);
+                m_blob = {};
+            }
+
+            writeShards();
+
+            if (fs::exists("libromfs_payload"))
+            {
+                for (const auto &entry : fs::directory_iterator("libromfs_payload"))
+                {
+                    if (!m_payloadFiles.contains(fs::absolute(entry.path())))
+                        fs::remove(entry.path());
+                }
+            }
+        }
+
+        // Expression for a span over the data added as name
+        std::string span(const std::string &name) const
+        {
+            if (m_alignment == 0)
+                return "{ " + name + ".data(), " + name + ".size() }";
+
+            const auto &[offset, size] = m_entries.at(name);
+            return "{ " + m_blobName + ".data() + " + std::to_string(offset) + ", " + std::to_string(size) + " }";
+        }
+
+    private:
+        void write(const std::string &name, const std::vector<std::uint8_t> &bytes, std::size_t alignment)
+        {
+            if (m_shardFiles.empty())
+            {
+                m_payloadFiles.insert(writePayload(m_outputFile, m_mode, name, bytes, alignment));
+                return;
+            }
+
+            m_pending.push_back({ name, bytes, alignment });
+        }
+
+        // Every array prefers the shard picked by the hash of its name, array names are derived from resource paths so
+        // that shard stays the same from one run to the next. Shards take at most a quarter more than an even share of
+        // the data, arrays that don't fit anymore move on to the next shard. Changing one resource therefore usually
+        // only changes the shard holding it
+        void writeShards()
+        {
+            if (m_pending.empty())
+                return;
+
+            std::sort(m_pending.begin(), m_pending.end(), [](const PendingArray &a, const PendingArray &b) { return a.name < b.name; });
+
+            std::uint64_t total = 0;
+            for (const auto &array : m_pending)
+                total += array.bytes.size();
+            const auto capacity = total / m_shardFiles.size() + total / m_shardFiles.size() / 4;
+
+            std::vector<std::uint64_t> shardSizes(m_shardFiles.size());
+            for (const auto &array : m_pending)
+            {
+                const auto preferred = hashBytes(reinterpret_cast<const std::uint8_t *>(array.name.data()), array.name.size()) % m_shardFiles.size();
+
+                auto shard = std::distance(shardSizes.begin(), std::min_element(shardSizes.begin(), shardSizes.end()));
+                for (std::size_t i = 0; i < m_shardFiles.size(); i++)
+                {
+                    const auto candidate = (preferred + i) % m_shardFiles.size();
+                    if (shardSizes[candidate] + array.bytes.size() <= capacity)
+                    {
+                        shard = candidate;
+                        break;
+                    }
+                }
+                shardSizes[shard] += array.bytes.size();
+
+                m_payloadFiles.insert(writePayload(m_shardFiles[shard], m_mode, array.name, array.bytes, array.alignment, true));
+                writePayloadDeclaration(m_outputFile, m_mode, array.name, array.bytes.size());
+            }
+
+            m_pending.clear();
+        }
+
+        struct PendingArray
+        {
+            std::string name;
+            std::vector<std::uint8_t> bytes;
+            std::size_t alignment;
+        };
+
+        std::ostream &m_outputFile;
+        std::vector<std::ostringstream> &m_shardFiles;
+        PayloadMode m_mode;
+        std::string m_blobName;
+        std::size_t m_alignment;
+
+        std::vector<std::uint8_t> m_blob;
+        std::map<std::string, std::pair<std::uint64_t, std::uint64_t>> m_entries;
+        std::vector<PendingArray> m_pending;
+        std::set<fs::path> m_payloadFiles;
+    };
 }
 
 int main(int argc, char *argv[])
 {
     if (argc < 3)
     {
-        std::printf("Usage: ./libromfs-generator <PROJECT_NAME> <RESOURCE_LOCATION>\n");
+        std::printf("Usage: ./libromfs-generator <PROJECT_NAME> <RESOURCE_LOCATION> [--chunk-size=<BYTES>] [--solid-block-size=<BYTES>] [--payload-mode=array|embed|incbin] [--blob-alignment=<BYTES>] [--shards=<COUNT>]\n");
         return 0;
     }
-    std::ofstream outputFile("libromfs_resources.cpp");
+
+    // Compressed resources larger than this get split into independently decompressible chunks, 0 disables chunking
+    [[maybe_unused]] std::size_t chunkSize = 256 * 1024;
+    // Compressed resources of up to a quarter of this size get packed together into blocks compressed as a whole, 0 disables solid blocks
+    [[maybe_unused]] std::size_t solidBlockSize = 0;
+    auto payloadMode = PayloadMode::Array;
+    // Puts all resources into a single blob, each starting at a multiple of this, 0 gives every resource an array of its own
+    std::size_t blobAlignment = 0;
+    // Spreads the resource data over this many additional files, so they can be compiled in parallel
+    std::size_t shardCount = 1;
+    for (int i = 3; i < argc; i++)
+    {
+        std::string_view argument = argv[i];
+        if (argument.starts_with("--chunk-size="))
+            chunkSize = std::strtoull(argv[i] + argument.find('=') + 1, nullptr, 10);
+        else if (argument.starts_with("--solid-block-size="))
+            solidBlockSize = std::strtoull(argv[i] + argument.find('=') + 1, nullptr, 10);
+        else if (argument == "--payload-mode=array")
+            payloadMode = PayloadMode::Array;
+        else if (argument == "--payload-mode=embed")
+            payloadMode = PayloadMode::Embed;
+        else if (argument == "--payload-mode=incbin")
+            payloadMode = PayloadMode::Incbin;
+        else if (argument.starts_with("--blob-alignment="))
+            blobAlignment = std::strtoull(argv[i] + argument.find('=') + 1, nullptr, 10);
+        else if (argument.starts_with("--shards="))
+            shardCount = std::strtoull(argv[i] + argument.find('=') + 1, nullptr, 10);
+        else
+            std::printf("[libromfs] Ignoring unknown option: %s\n", argv[i]);
+    }
+
+    if (!std::has_single_bit(blobAlignment) && blobAlignment != 0)
+    {
+        std::printf("[libromfs] Blob alignment has to be a power of two!\n");
+        return 1;
+    }
+
+    if (blobAlignment != 0 && shardCount > 1)
+        std::printf("[libromfs] The blob can't be split, all resource data goes into a single shard\n");
+
+    // A single shard is the index file itself. Everything is generated in memory first, files that come out the same as before are left alone
+    std::ostringstream outputFile;
+    std::vector<std::ostringstream> shardFiles(shardCount > 1 ? shardCount : 0);
+    for (std::size_t i = 0; i < shardFiles.size(); i++)
+    {
+        auto &shardFile = shardFiles[i];
+        shardFile << "#include <romfs/romfs.hpp>\n\n";
+        shardFile << "#include <array>\n";
+        shardFile << "#include <cstdint>\n\n";
+        shardFile << "/* Resource data, shard " << i << " of " << shardCount << " */\n";
+    }
+    PayloadLayout payloads(outputFile, shardFiles, payloadMode, "resource_blob_" + std::string(argv[1]), blobAlignment);
 
     std::printf("[libromfs] Resource Folder: %s\n", argv[2]);
 
@@ -215,6 +1168,11 @@ int main(int argc, char *argv[])
     // Read patterns from .romfsignore file
     excludePatterns = parseIgnoreFile(argv[2]);
 
+    // Read per resource compression policies from .romfscompress file
+    [[maybe_unused]] std::vector<CompressionPolicy> compressionPolicies;
+    if (!parseCompressionFile(argv[2], compressionPolicies))
+        return 1;
+
     outputFile << "#include <romfs/romfs.hpp>\n\n";
     outputFile << "#include <array>\n";
     outputFile << "#include <cstdint>\n";
@@ -231,11 +1189,17 @@ int main(int argc, char *argv[])
     outputFile << "0";
 #endif
     outputFile << ", \"Compression mismatch: generated resources and library must both be compiled with or without LIBROMFS_COMPRESS_RESOURCES\");\n";
+#if defined(LIBROMFS_COMPRESS_RESOURCES)
+    outputFile << "#ifndef LIBROMFS_COMPRESSION_CODEC\n";
+    outputFile << "    #define LIBROMFS_COMPRESSION_CODEC 1\n";
+    outputFile << "#endif\n";
+    outputFile << "static_assert(LIBROMFS_COMPRESSION_CODEC == " << LIBROMFS_COMPRESSION_CODEC << ", \"Compression codec mismatch: generated resources and library must both be compiled with the same LIBROMFS_COMPRESSION_CODEC\");\n";
+#endif
     outputFile << "\n\n";
     outputFile << "/* Resource definitions */\n";
 
-    std::vector<fs::path> paths;
-    std::uint64_t identifierCount = 0;
+    std::vector<fs::path> files;
+    std::vector<fs::path> relativePaths;
     for (const auto &entry : fs::recursive_directory_iterator(argv[2]))
     {
         auto &p = entry.path();
@@ -246,7 +1210,7 @@ int main(int argc, char *argv[])
         auto relativePath = fs::relative(entry.path(), fs::absolute(argv[2]));
 
         std::string filename = path.filename().string();
-        if (filename == ".DS_Store" || filename == ".romfsignore")
+        if (filename == ".DS_Store" || filename == ".romfsignore" || filename == ".romfscompress")
         {
             std::printf("[libromfs] SKIP: %s\n", relativePath.string().c_str());
             continue;
@@ -258,79 +1222,267 @@ int main(int argc, char *argv[])
             continue;
         }
 
-        std::vector<std::uint8_t> inputData;
-        inputData.resize(fs::file_size(p));
+        files.push_back(p);
+        relativePaths.push_back(relativePath);
+    }
 
-        auto file = std::fopen(entry.path().string().c_str(), "rb");
-        inputData.resize(std::fread(inputData.data(), 1, fs::file_size(p), file));
-        std::fclose(file);
+#if defined(LIBROMFS_COMPRESS_RESOURCES)
+    // Everything besides the data itself that changes the compressed result, bump the version whenever the compressors change
+    const std::string compressionSettings = "version=1 codec=" + std::to_string(LIBROMFS_COMPRESSION_CODEC) + " chunk-size=" + std::to_string(chunkSize);
+    auto compressionSettingsHash = hashBytes(reinterpret_cast<const std::uint8_t *>(compressionSettings.data()), compressionSettings.size());
+#endif
+#if defined(LIBROMFS_COMPRESS_RESOURCES) && LIBROMFS_COMPRESSION_CODEC == LIBROMFS_CODEC_ZSTD
+    Compressor compressor(loadOrTrainDictionary(files, relativePaths, "libromfs_cache"));
+    compressionSettingsHash = hashBytes(compressor.dictionary(), compressionSettingsHash);
+#elif defined(LIBROMFS_COMPRESS_RESOURCES)
+    Compressor compressor;
+#endif
+#if defined(LIBROMFS_COMPRESS_RESOURCES)
+    CompressionCache compressionCache("libromfs_cache", compressionSettingsHash);
+#endif
 
-        inputData.push_back(0x00);
+    std::vector<fs::path> paths;
+    std::vector<std::string> keys;
+    std::vector<std::size_t> sizes;
+    std::vector<bool> compressed;
+    std::vector<std::vector<std::uint64_t>> chunkOffsets;
+    std::vector<std::string> payloadNames;
+    std::map<std::uint64_t, std::vector<std::uint8_t>> solidData;
+    std::uint64_t identifierCount = 0;
+    for (std::size_t fileIndex = 0; fileIndex < files.size(); fileIndex++)
+    {
+        const auto &relativePath = relativePaths[fileIndex];
+        std::vector<std::uint8_t> inputData = readFile(files[fileIndex]);
+        const auto size = inputData.size();
 
         std::vector<std::uint8_t> bytes;
+        std::vector<std::uint64_t> offsets;
+        bool isCompressed = false;
 #if defined(LIBROMFS_COMPRESS_RESOURCES)
-        z_stream stream;
-        stream.zalloc = Z_NULL;
-        stream.zfree = Z_NULL;
-        stream.opaque = Z_NULL;
-        stream.avail_in = inputData.size();
-        stream.next_in = inputData.data();
-
-        if (deflateInit(&stream, Z_BEST_COMPRESSION) != Z_OK)
+        auto policy = findCompressionPolicy(relativePath, compressionPolicies);
+        if (policy.mode != CompressionPolicy::Mode::Store && solidBlockSize != 0 && size <= solidBlockSize / 4)
         {
+            // Small resources say little about how well they compress on their own, so they only ever get compressed
+            // as part of the solid block they are packed into once all resources are known
+            paths.push_back(relativePath);
+            keys.push_back(relativePath.generic_string());
+            sizes.push_back(size);
+            compressed.push_back(true);
+            chunkOffsets.emplace_back();
+            payloadNames.emplace_back();
+            solidData[identifierCount] = std::move(inputData);
+
+            identifierCount++;
             continue;
         }
 
-        // Estimate the compressed size and allocate the buffer
-        bytes.resize(inputData.size() * 1.1 + 12); // Slightly larger than the input size
+        if (policy.mode != CompressionPolicy::Mode::Store)
+        {
+            if (!compressionCache.compress(compressor, relativePath.generic_string(), inputData, chunkSize, bytes, offsets))
+            {
+                std::printf("[libromfs] Failed to compress: %s\n", relativePath.string().c_str());
+                continue;
+            }
 
-        stream.avail_out = bytes.size();
-        stream.next_out = bytes.data();
+            // Data that doesn't shrink (images, fonts, archives, ...) is cheaper to embed as is
+            isCompressed = policy.mode == CompressionPolicy::Mode::Compress || bytes.size() <= inputData.size() * policy.threshold;
+            if (!isCompressed)
+                std::printf("[libromfs] Storing uncompressed: %s\n", relativePath.string().c_str());
+        }
+#endif
 
-        // Perform the compression
-        if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+        if (!isCompressed)
         {
-            deflateEnd(&stream);
-            continue;
+            // Uncompressed resources carry their null terminator, compressed ones get it appended when decompressing
+            inputData.push_back(0x00);
+            bytes = std::move(inputData);
+            offsets.clear();
         }
 
-        // Resize the output buffer to the actual size
-        bytes.resize(stream.total_out);
+        // Named after the path rather than the position in the directory, so adding a file doesn't rename all that come after it
+        const auto payloadName = "resource_" + std::string(argv[1]) + "_" + toHex(hashPath(relativePath.generic_string()));
+        payloads.add(payloadName, bytes);
 
-        // Clean up
-        deflateEnd(&stream);
-#else
-        bytes = std::move(inputData);
-#endif
+        if (!offsets.empty())
+        {
+            outputFile << "static constexpr std::array<std::uint64_t, " << offsets.size() << "> " << "resource_chunks_" + std::string(argv[1]) + "_" << identifierCount << " = {\n";
+            outputFile << "    ";
 
-        outputFile << "static std::array<std::uint8_t, " << bytes.size() << "> " << "resource_" + std::string(argv[1]) + "_" << identifierCount << " = {\n";
-        outputFile << "    ";
+            for (auto offset : offsets)
+            {
+                outputFile << offset << ",";
+            }
 
-        for (auto byte : bytes)
-        {
-            outputFile << static_cast<std::uint32_t>(byte) << ",";
+            outputFile << " };\n\n";
         }
 
-        outputFile << " };\n\n";
-
         paths.push_back(relativePath);
+        keys.push_back(relativePath.generic_string());
+        sizes.push_back(size);
+        compressed.push_back(isCompressed);
+        chunkOffsets.push_back(std::move(offsets));
+        payloadNames.push_back(payloadName);
 
         identifierCount++;
     }
 
     outputFile << "\n";
 
+    // Emit all tables in directory order, the resource arrays above keep their identifiers
+    std::vector<std::uint64_t> order(identifierCount);
+    for (std::uint64_t i = 0; i < identifierCount; i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](std::uint64_t a, std::uint64_t b)
+              { return filePreorderLess(keys[a], keys[b]); });
+
+    std::vector<std::string> sortedKeys;
+    for (auto index : order)
+        sortedKeys.push_back(keys[index]);
+
+    // Pack small resources into solid blocks in table order, so neighbouring files of a directory end up together.
+    // Every resource keeps its null terminator inside the block, so it can be served from the block's data as is
+    std::vector<std::uint64_t> blockSizes;
+    std::vector<std::vector<std::uint64_t>> blockChunkOffsets;
+    std::vector<std::string> blockNames;
+    std::map<std::uint64_t, std::pair<std::uint64_t, std::uint64_t>> solidLocations;
+#if defined(LIBROMFS_COMPRESS_RESOURCES)
+    {
+        std::vector<std::uint8_t> block;
+        std::string blockKey;
+        auto flushBlock = [&]
+        {
+            std::vector<std::uint8_t> bytes;
+            std::vector<std::uint64_t> offsets;
+            if (!compressionCache.compress(compressor, "solid block " + std::to_string(blockSizes.size()), block, chunkSize, bytes, offsets))
+                return false;
+
+            // Named after the path of the block's first resource, like the arrays of resources themselves
+            blockNames.push_back("solid_block_" + std::string(argv[1]) + "_" + toHex(hashPath(blockKey)));
+            payloads.add(blockNames.back(), bytes);
+
+            if (!offsets.empty())
+            {
+                outputFile << "static constexpr std::array<std::uint64_t, " << offsets.size() << "> " << "solid_block_chunks_" + std::string(argv[1]) + "_" << blockSizes.size() << " = {\n";
+                outputFile << "    ";
+
+                for (auto offset : offsets)
+                {
+                    outputFile << offset << ",";
+                }
+
+                outputFile << " };\n\n";
+            }
+
+            std::printf("[libromfs] Packed solid block %zu: %zu bytes compressed to %zu\n", blockSizes.size(), block.size(), bytes.size());
+
+            blockSizes.push_back(block.size());
+            blockChunkOffsets.push_back(std::move(offsets));
+            block.clear();
+            return true;
+        };
+
+        for (auto i : order)
+        {
+            auto it = solidData.find(i);
+            if (it == solidData.end())
+                continue;
+
+            if (!block.empty() && block.size() + it->second.size() + 1 > solidBlockSize && !flushBlock())
+            {
+                std::printf("[libromfs] Failed to compress solid block!\n");
+                return 1;
+            }
+
+            if (block.empty())
+                blockKey = keys[i];
+
+            solidLocations[i] = { blockSizes.size(), block.size() };
+            block.insert(block.end(), it->second.begin(), it->second.end());
+            block.push_back(0x00);
+        }
+
+        if (!block.empty() && !flushBlock())
+        {
+            std::printf("[libromfs] Failed to compress solid block!\n");
+            return 1;
+        }
+    }
+#endif
+
+    payloads.finish();
+
+    // Every compressed resource and solid block gets a fixed place in the library's arena, in the order of the resource table
+    const auto stateCount = std::count(compressed.begin(), compressed.end(), true) - solidData.size();
+    [[maybe_unused]] std::uint64_t decompressedSize = 0;
+    {
+        std::vector<std::uint64_t> stateSizes;
+        for (auto i : order)
+        {
+            if (compressed[i] && !solidData.contains(i))
+                stateSizes.push_back(sizes[i]);
+        }
+        stateSizes.insert(stateSizes.end(), blockSizes.begin(), blockSizes.end());
+
+        // Nothing refers to the states when every resource is stored uncompressed
+        if (!stateSizes.empty())
+        {
+            outputFile << "/* Lazily decompressed resource data */\n";
+            outputFile << "constinit static std::array<romfs::impl::ResourceState, " << stateSizes.size() << "> resource_states_" + std::string(argv[1]) + " = {{\n";
+
+            for (auto size : stateSizes)
+            {
+                outputFile << "    romfs::impl::ResourceState(" << decompressedSize << "),\n";
+
+                // Room for the null terminator, aligned like any other allocation
+                constexpr std::uint64_t Alignment = alignof(std::max_align_t);
+                decompressedSize += (size + 1 + Alignment - 1) / Alignment * Alignment;
+            }
+
+            outputFile << "}};\n\n";
+        }
+    }
+
+    if (!blockSizes.empty())
+    {
+        outputFile << "/* Solid blocks */\n";
+        outputFile << "static constexpr std::array<romfs::Resource, " << blockSizes.size() << "> solid_blocks_" + std::string(argv[1]) + " = {{\n";
+
+        for (std::size_t i = 0; i < blockSizes.size(); i++)
+        {
+            outputFile << "    romfs::Resource(" << payloads.span(blockNames[i]) << ", " << blockSizes[i] << ", resource_states_" + std::string(argv[1]) + "[" << stateCount + i << "]";
+            if (!blockChunkOffsets[i].empty())
+                outputFile << ", { solid_block_chunks_" + std::string(argv[1]) + "_" << i << ".data(), solid_block_chunks_" + std::string(argv[1]) + "_" << i << ".size() }";
+            outputFile << "),\n";
+        }
+        outputFile << "}};\n\n";
+    }
+
+    outputFile << "\n\n";
+
     {
         outputFile << "/* Resource map */\n";
-        outputFile << "ROMFS_VISIBILITY nonstd::span<romfs::impl::ResourceLocation> RomFs_" + std::string(argv[1]) + "_get_resources() {\n";
-        outputFile << "    static std::array<romfs::impl::ResourceLocation, " << identifierCount << "> resources = {{\n";
+        outputFile << "ROMFS_VISIBILITY nonstd::span<const romfs::impl::ResourceLocation> RomFs_" + std::string(argv[1]) + "_get_resources() {\n";
+        outputFile << "    static constexpr std::array<romfs::impl::ResourceLocation, " << identifierCount << "> resources = {{\n";
 
-        for (std::uint64_t i = 0; i < identifierCount; i++)
+        std::uint64_t stateIndex = 0;
+        for (auto i : order)
         {
 
             std::printf("[libromfs] Bundling resource: %s\n", paths[i].string().c_str());
 
-            outputFile << "        " << "romfs::impl::ResourceLocation { \"" << toPathString(paths[i].string()) << "\", romfs::Resource({ reinterpret_cast<std::byte*>(resource_" + std::string(argv[1]) + "_" << i << ".data()), " << "resource_" + std::string(argv[1]) + "_" << i << ".size() }) " << "},\n";
+            if (auto it = solidLocations.find(i); it != solidLocations.end())
+            {
+                outputFile << "        " << "romfs::impl::ResourceLocation { \"" << toPathString(paths[i].string()) << "\", romfs::Resource(solid_blocks_" + std::string(argv[1]) + "[" << it->second.first << "], " << it->second.second << ", " << sizes[i] << ") },\n";
+                continue;
+            }
+
+            outputFile << "        " << "romfs::impl::ResourceLocation { \"" << toPathString(paths[i].string()) << "\", romfs::Resource(" << payloads.span(payloadNames[i]);
+            // Uncompressed resources have no state, their embedded bytes are returned directly
+            if (compressed[i])
+                outputFile << ", " << sizes[i] << ", resource_states_" + std::string(argv[1]) + "[" << stateIndex++ << "]";
+            if (!chunkOffsets[i].empty())
+                outputFile << ", { resource_chunks_" + std::string(argv[1]) + "_" << i << ".data(), " << "resource_chunks_" + std::string(argv[1]) + "_" << i << ".size() }";
+            outputFile << ") " << "},\n";
         }
         outputFile << "    }};";
 
@@ -342,10 +1494,10 @@ int main(int argc, char *argv[])
 
     {
         outputFile << "/* Resource paths */\n";
-        outputFile << "ROMFS_VISIBILITY nonstd::span<std::string_view> RomFs_" + std::string(argv[1]) + "_get_paths() {\n";
-        outputFile << "    static std::array<std::string_view, " << identifierCount << "> paths = {{\n";
+        outputFile << "ROMFS_VISIBILITY nonstd::span<const std::string_view> RomFs_" + std::string(argv[1]) + "_get_paths() {\n";
+        outputFile << "    static constexpr std::array<std::string_view, " << identifierCount << "> paths = {{\n";
 
-        for (std::uint64_t i = 0; i < identifierCount; i++)
+        for (auto i : order)
         {
             outputFile << "        \"" << toPathString(paths[i].string()) << "\",\n";
         }
@@ -357,6 +1509,111 @@ int main(int argc, char *argv[])
 
     outputFile << "\n\n";
 
+    {
+        PerfectHash perfectHash;
+        if (!buildPerfectHash(sortedKeys, perfectHash))
+        {
+            std::printf("[libromfs] Failed to build resource lookup table!\n");
+            return 1;
+        }
+
+        outputFile << "/* Resource lookup table */\n";
+        writeLookupTable(outputFile, "RomFs_" + std::string(argv[1]) + "_get", perfectHash);
+    }
+
+    outputFile << "\n\n";
+
+    {
+        // Every directory that contains a resource somewhere below it, including the root ""
+        std::set<std::string> directorySet = { "" };
+        for (const auto &key : sortedKeys)
+        {
+            for (auto parent = parentPath(key); !parent.empty(); parent = parentPath(parent))
+                directorySet.insert(parent);
+        }
+
+        std::vector<std::string> directories(directorySet.begin(), directorySet.end());
+        std::sort(directories.begin(), directories.end(), directoryPreorderLess);
+
+        std::map<std::string, std::pair<std::size_t, std::size_t>> fileRanges;
+        for (std::size_t i = 0; i < sortedKeys.size(); i++)
+        {
+            auto [it, inserted] = fileRanges.try_emplace(parentPath(sortedKeys[i]), i, i);
+            it->second.second = i + 1;
+        }
+
+        outputFile << "/* Directory table */\n";
+        outputFile << "ROMFS_VISIBILITY nonstd::span<const romfs::impl::DirectoryLocation> RomFs_" + std::string(argv[1]) + "_get_directories() {\n";
+        outputFile << "    static constexpr std::array<romfs::impl::DirectoryLocation, " << directories.size() << "> directories = {{\n";
+
+        for (std::size_t i = 0; i < directories.size(); i++)
+        {
+            std::pair<std::size_t, std::size_t> range = { 0, 0 };
+            if (auto it = fileRanges.find(directories[i]); it != fileRanges.end())
+                range = it->second;
+
+            // Subdirectories follow their parent directly, so the whole subtree is one contiguous range
+            std::size_t directoryEnd = i + 1;
+            while (directoryEnd < directories.size() && isAncestorPath(directories[i], directories[directoryEnd]))
+                directoryEnd++;
+
+            outputFile << "        " << "romfs::impl::DirectoryLocation { \"" << toPathString(directories[i]) << "\", " << range.first << ", " << range.second << ", " << directoryEnd << " },\n";
+        }
+        outputFile << "    }};";
+
+        outputFile << "\n\n    return directories;\n";
+        outputFile << "}\n\n";
+
+        PerfectHash perfectHash;
+        if (!buildPerfectHash(directories, perfectHash))
+        {
+            std::printf("[libromfs] Failed to build directory lookup table!\n");
+            return 1;
+        }
+
+        outputFile << "/* Directory lookup table */\n";
+        writeLookupTable(outputFile, "RomFs_" + std::string(argv[1]) + "_get_directory", perfectHash);
+    }
+
+    outputFile << "\n\n";
+
+#if defined(LIBROMFS_COMPRESS_RESOURCES)
+    {
+        outputFile << "/* Decompressed size of every chunk of a chunked resource */\n";
+        outputFile << "ROMFS_VISIBILITY std::uint64_t RomFs_" + std::string(argv[1]) + "_get_chunk_size() {\n";
+        outputFile << "    return " << chunkSize << ";\n";
+        outputFile << "}\n\n";
+    }
+
+    {
+        outputFile << "/* Space needed to hold every compressed resource decompressed at once */\n";
+        outputFile << "ROMFS_VISIBILITY std::uint64_t RomFs_" + std::string(argv[1]) + "_get_decompressed_size() {\n";
+        outputFile << "    return " << decompressedSize << ";\n";
+        outputFile << "}\n\n";
+    }
+
+    outputFile << "\n\n";
+#endif
+
+#if defined(LIBROMFS_COMPRESS_RESOURCES) && LIBROMFS_COMPRESSION_CODEC == LIBROMFS_CODEC_ZSTD
+    {
+        outputFile << "/* Compression dictionary shared by all resources */\n";
+        outputFile << "ROMFS_VISIBILITY nonstd::span<const std::uint8_t> RomFs_" + std::string(argv[1]) + "_get_dictionary() {\n";
+        outputFile << "    static constexpr std::array<std::uint8_t, " << compressor.dictionary().size() << "> dictionary = {\n";
+        outputFile << "        ";
+        for (auto byte : compressor.dictionary())
+        {
+            outputFile << static_cast<std::uint32_t>(byte) << ",";
+        }
+        outputFile << "\n    };";
+
+        outputFile << "\n\n    return dictionary;\n";
+        outputFile << "}\n\n";
+    }
+
+    outputFile << "\n\n";
+#endif
+
     {
         outputFile << "/* RomFS name */\n";
         outputFile << "ROMFS_VISIBILITY const char* RomFs_" + std::string(argv[1]) + "_get_name() {\n";
@@ -365,4 +1622,12 @@ int main(int argc, char *argv[])
     }
 
     outputFile << "\n\n";
+
+#if defined(LIBROMFS_COMPRESS_RESOURCES)
+    compressionCache.finish();
+#endif
+
+    writeIfChanged("libromfs_resources.cpp", outputFile.str());
+    for (std::size_t i = 0; i < shardFiles.size(); i++)
+        writeIfChanged("libromfs_resources_" + std::to_string(i) + ".cpp", shardFiles[i].str());
 }
\ No newline at end of file
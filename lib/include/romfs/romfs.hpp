@@ -1,8 +1,23 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <ranges>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 #if __cplusplus > 202002L
 #include <span>
@@ -30,31 +45,88 @@ namespace fs = std::filesystem;
 namespace romfs {
 
     namespace impl {
-        ROMFS_VISIBILITY void ROMFS_CONCAT(decompress_if_needed_, LIBROMFS_PROJECT_NAME)(std::vector<std::byte> &decompressedData, nonstd::span<const std::byte> compressedData);
+
+        /* Decompressed copy of a resource. Lives next to the generated resource table and is shared by all copies of a Resource */
+        struct ResourceState {
+            /* The low bits of status hold one of these, the bits above count the pins keeping the data from being evicted */
+            enum Status : std::uint32_t {
+                Empty,
+                Decompressing,
+                Ready,
+                Evicting
+            };
+
+            static constexpr std::uint32_t StatusMask = 0b11;
+            static constexpr std::uint32_t OnePin = 1U << 2;
+            /* Set once data() handed out a raw pointer, the data then stays around for the rest of the process */
+            static constexpr std::uint32_t PinnedForever = 1U << 31;
+
+            ResourceState() = default;
+            constexpr explicit ResourceState(std::size_t arenaOffset) : arenaOffset(arenaOffset) {}
+
+            std::atomic<std::uint32_t> status = Empty;
+            std::atomic<bool> referenced = false;
+            /* Only changes while status is Decompressing or Evicting. Atomic since data() peeks at it without pinning */
+            std::atomic<std::byte*> data = nullptr;
+            /* Where data has been allocated from, it goes back there once evicted */
+            std::pmr::memory_resource *allocator = nullptr;
+            /* Place of data inside the arena, see romfs::use_arena() */
+            std::size_t arenaOffset = 0;
+        };
+
+        /* Lets the library implementation reach the internals of a Resource */
+        struct ResourceAccess;
+
+    }
+
+    class Resource;
+    class Pin;
+
+    /* Memory currently held in decompressed form, see romfs::cache_usage() */
+    struct CacheUsage {
+        std::size_t used;
+        std::size_t pinned;
+        std::size_t budget;
+    };
+
+    namespace impl {
+
+        /* Decompresses the resource unless it's already cached and pins it. The first caller decompresses, */
+        /* concurrent callers block until it's done and then share the result */
+        ROMFS_VISIBILITY const std::byte* ROMFS_CONCAT(pin_, LIBROMFS_PROJECT_NAME)(const Resource &resource, bool forever);
+        ROMFS_VISIBILITY void ROMFS_CONCAT(unpin_, LIBROMFS_PROJECT_NAME)(const Resource &resource) noexcept;
+        ROMFS_VISIBILITY bool ROMFS_CONCAT(release_, LIBROMFS_PROJECT_NAME)(const Resource &resource);
+
+        /* Decompresses only the chunks of a resource covering [offset, offset + length) into dst */
+        ROMFS_VISIBILITY void ROMFS_CONCAT(read_, LIBROMFS_PROJECT_NAME)(const Resource &resource, std::size_t offset, std::size_t length, std::byte *dst);
+
     }
 
     class Resource {
     public:
         Resource() = default;
-        explicit constexpr Resource(const nonstd::span<std::byte> &content) : m_compressedData(content) {}
+        /* Uncompressed content, including a trailing null terminator */
+        explicit constexpr Resource(const nonstd::span<const std::uint8_t> &content) : m_compressedData(content), m_size(content.empty() ? 0 : content.size() - 1) {}
+        /* Compressed content that decompresses to size bytes. Large resources are split into independently */
+        /* compressed chunks, chunkOffsets then holds where each of them starts in content followed by content's size */
+        constexpr Resource(const nonstd::span<const std::uint8_t> &content, std::size_t size, impl::ResourceState &state, nonstd::span<const std::uint64_t> chunkOffsets = {})
+            : m_compressedData(content), m_size(size), m_state(&state), m_chunkOffsets(chunkOffsets) {}
+        /* Resource of size bytes at offset inside of a solid block, a compressed resource holding many small ones. */
+        /* All of them share the block's decompressed data */
+        constexpr Resource(const Resource &block, std::size_t offset, std::size_t size)
+            : m_compressedData(block.m_compressedData), m_size(size), m_state(block.m_state), m_chunkOffsets(block.m_chunkOffsets), m_block(&block), m_offset(offset) {}
 
         [[nodiscard]]
         const std::byte* data() const {
-            impl::ROMFS_CONCAT(decompress_if_needed_, LIBROMFS_PROJECT_NAME)(m_decompressedData, m_compressedData);
-            if (!m_decompressedData.empty())
-                return this->m_decompressedData.data();
+            if (auto decompressedData = this->decompressed(); decompressedData != nullptr)
+                return decompressedData;
             else
-                return this->m_compressedData.data();
+                return reinterpret_cast<const std::byte*>(this->m_compressedData.data());
         }
 
         [[nodiscard]]
         std::size_t size() const {
-            impl::ROMFS_CONCAT(decompress_if_needed_, LIBROMFS_PROJECT_NAME)(m_decompressedData, m_compressedData);
-
-            if (!this->m_decompressedData.empty())
-                return this->m_decompressedData.size() - 1;
-            else
-                return m_compressedData.size_bytes() - 1;
+            return this->m_size;
         }
 
         [[nodiscard]]
@@ -62,14 +134,196 @@ namespace romfs {
             return { reinterpret_cast<const char*>(this->data()), this->size() };
         }
 
+        /* Copies up to length bytes starting at offset into dst and returns how many were copied. */
+        /* Compressed resources that haven't been decompressed yet only decompress the chunks covering the range */
+        std::size_t read(std::size_t offset, std::size_t length, std::byte *dst) const {
+            if (offset >= this->m_size)
+                return 0;
+
+            length = std::min(length, this->m_size - offset);
+            if (length == 0)
+                return 0;
+
+            // Compressed resources are always read through a pin, even data pinned forever can be released meanwhile
+            if (this->m_state == nullptr)
+                std::memcpy(dst, this->m_compressedData.data() + offset, length);
+            else
+                impl::ROMFS_CONCAT(read_, LIBROMFS_PROJECT_NAME)(*this, offset, length, dst);
+
+            return length;
+        }
+
+        /* Size of the resource once decompressed, the same as size(). Lets callers size the buffer for decompress_into() */
+        [[nodiscard]]
+        std::size_t uncompressed_size() const {
+            return this->m_size;
+        }
+
+        /* Decompresses the whole resource straight into dst, without keeping a decompressed copy around. */
+        /* Throws std::invalid_argument if dst is smaller than uncompressed_size(), returns the number of bytes written */
+        std::size_t decompress_into(nonstd::span<std::byte> dst) const {
+            if (dst.size() < this->m_size)
+                throw std::invalid_argument("Buffer too small to decompress romfs resource into");
+
+            return this->read(0, this->m_size, dst.data());
+        }
+
+        /* Keeps the decompressed data of the resource around for as long as the returned Pin lives, */
+        /* unlike data() which keeps it around forever. Unpinned data may get evicted, see set_cache_budget() */
+        [[nodiscard]] Pin pin() const;
+
+        /* Frees the decompressed data of the resource unless a Pin still holds on to it, returns whether anything was freed. */
+        /* Resources in a solid block share its data, releasing one of them releases all of them */
+        /* Pointers returned by data() and string() must not be used anymore afterwards, the next call decompresses again */
+        bool release() const {
+            return impl::ROMFS_CONCAT(release_, LIBROMFS_PROJECT_NAME)(*this);
+        }
+
+        /* Whether the resource is embedded compressed, see .romfscompress */
+        [[nodiscard]]
+        bool compressed() const {
+            return this->m_state != nullptr;
+        }
+
         [[nodiscard]]
         bool valid() const {
             return !this->m_compressedData.empty() && this->m_compressedData.data() != nullptr;
         }
 
     private:
-        mutable std::vector<std::byte> m_decompressedData;
-        nonstd::span<const std::byte> m_compressedData;
+        [[nodiscard]]
+        const std::byte* decompressed() const {
+            if (this->m_state == nullptr)
+                return nullptr;
+
+            // Once pinned forever, the data only goes away through release() so two loads are enough. Data that is
+            // being evicted reads as nullptr and goes the slow way
+            if (this->m_state->status.load(std::memory_order_acquire) & impl::ResourceState::PinnedForever) {
+                if (auto data = this->m_state->data.load(std::memory_order_acquire); data != nullptr)
+                    return data + this->m_offset;
+            }
+
+            return impl::ROMFS_CONCAT(pin_, LIBROMFS_PROJECT_NAME)(*this, true);
+        }
+
+        friend struct impl::ResourceAccess;
+
+        nonstd::span<const std::uint8_t> m_compressedData;
+        std::size_t m_size = 0;
+        impl::ResourceState *m_state = nullptr;
+        nonstd::span<const std::uint64_t> m_chunkOffsets;
+        const Resource *m_block = nullptr;
+        std::size_t m_offset = 0;
+    };
+
+    /* Keeps the decompressed data of a resource from being evicted while it's alive */
+    class Pin {
+    public:
+        Pin() = default;
+        Pin(const Resource &resource, const std::byte *data) noexcept : m_resource(resource), m_data(data) {}
+
+        Pin(const Pin &) = delete;
+        Pin& operator=(const Pin &) = delete;
+
+        Pin(Pin &&other) noexcept : m_resource(other.m_resource), m_data(std::exchange(other.m_data, nullptr)) {}
+        Pin& operator=(Pin &&other) noexcept {
+            if (this != &other) {
+                this->reset();
+                this->m_resource = other.m_resource;
+                this->m_data = std::exchange(other.m_data, nullptr);
+            }
+
+            return *this;
+        }
+
+        ~Pin() {
+            this->reset();
+        }
+
+        void reset() noexcept {
+            if (this->m_data != nullptr && this->m_resource.compressed())
+                impl::ROMFS_CONCAT(unpin_, LIBROMFS_PROJECT_NAME)(this->m_resource);
+
+            this->m_data = nullptr;
+        }
+
+        [[nodiscard]] const std::byte* data() const noexcept { return this->m_data; }
+        [[nodiscard]] std::size_t size() const noexcept { return this->m_data == nullptr ? 0 : this->m_resource.size(); }
+        [[nodiscard]] std::string_view string() const noexcept { return { reinterpret_cast<const char*>(this->m_data), this->size() }; }
+        [[nodiscard]] explicit operator bool() const noexcept { return this->m_data != nullptr; }
+
+    private:
+        Resource m_resource;
+        const std::byte *m_data = nullptr;
+    };
+
+    inline Pin Resource::pin() const {
+        if (this->m_state == nullptr)
+            return { *this, reinterpret_cast<const std::byte*>(this->m_compressedData.data()) };
+
+        return { *this, impl::ROMFS_CONCAT(pin_, LIBROMFS_PROJECT_NAME)(*this, false) };
+    }
+
+    namespace impl {
+
+        /* Decompression running on the executor, shared by everybody waiting for the same resource */
+        struct AsyncOperation {
+            std::mutex mutex;
+            std::condition_variable condition;
+            bool done = false;
+            std::exception_ptr error;
+            std::vector<std::function<void()>> continuations;
+
+            /* Queues continuation to run once the operation is done, returns false without queueing it if it's done already */
+            bool subscribe(std::function<void()> continuation) {
+                std::scoped_lock lock(this->mutex);
+                if (this->done)
+                    return false;
+
+                this->continuations.push_back(std::move(continuation));
+                return true;
+            }
+
+            void wait() {
+                std::unique_lock lock(this->mutex);
+                this->condition.wait(lock, [this] { return this->done; });
+            }
+        };
+
+    }
+
+    /* Result of romfs::get_async(). Can be co_await'ed, which resumes the coroutine on the executor */
+    /* thread that did the decompression, or waited for with get(). Both yield a Pin of the resource */
+    class AsyncResource {
+    public:
+        AsyncResource(const Resource &resource, std::shared_ptr<impl::AsyncOperation> operation) : m_resource(resource), m_operation(std::move(operation)) {}
+
+        [[nodiscard]] bool ready() const {
+            if (this->m_operation == nullptr)
+                return true;
+
+            std::scoped_lock lock(this->m_operation->mutex);
+            return this->m_operation->done;
+        }
+
+        /* Blocks until the resource is decompressed, rethrows if decompressing it failed */
+        [[nodiscard]] Pin get() const {
+            if (this->m_operation != nullptr) {
+                this->m_operation->wait();
+                if (this->m_operation->error != nullptr)
+                    std::rethrow_exception(this->m_operation->error);
+            }
+
+            return this->m_resource.pin();
+        }
+
+        [[nodiscard]] bool await_ready() const { return this->ready(); }
+        [[nodiscard]] bool await_suspend(std::coroutine_handle<> handle) { return this->m_operation->subscribe([handle] { handle.resume(); }); }
+        [[nodiscard]] Pin await_resume() const { return this->get(); }
+
+    private:
+        Resource m_resource;
+        std::shared_ptr<impl::AsyncOperation> m_operation;
     };
 
     namespace impl {
@@ -79,14 +333,239 @@ namespace romfs {
             Resource resource;
         };
 
+        /* Resources are generated sorted by directory, [fileBegin, fileEnd) are the files directly inside this one */
+        /* Directories are sorted depth first, (this, directoryEnd) are all directories below this one */
+        struct DirectoryLocation {
+            std::string_view path;
+            std::uint32_t fileBegin;
+            std::uint32_t fileEnd;
+            std::uint32_t directoryEnd;
+        };
+
+        /* Incremental decoder behind a Reader, implemented by the library for the codec it has been built with */
+        struct ReaderState {
+            virtual ~ReaderState() = default;
+
+            /* Fills buffer with the next decompressed bytes of the resource, returns how many were written. */
+            /* Less than the whole buffer only gets written once the compressed data has ended */
+            virtual std::size_t read(nonstd::span<std::byte> buffer) = 0;
+        };
+
+    }
+
+    /* Sequential reader returned by romfs::open(). Compressed resources are decompressed incrementally */
+    /* into the buffers passed to read(), without ever holding the whole decompressed resource in memory */
+    class Reader {
+    public:
+        Reader() = default;
+        Reader(const Resource &resource, std::unique_ptr<impl::ReaderState> state) : m_resource(resource), m_state(std::move(state)) {}
+
+        /* Copies the next bytes of the resource into buffer, returns how many were copied and 0 once the end has been reached */
+        std::size_t read(nonstd::span<std::byte> buffer) {
+            auto length = std::min(buffer.size(), this->m_resource.size() - this->m_position);
+            if (length == 0)
+                return 0;
+
+            if (this->m_state != nullptr)
+                length = this->m_state->read(buffer.first(length));
+            else
+                this->m_resource.read(this->m_position, length, buffer.data());
+
+            this->m_position += length;
+            return length;
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept { return this->m_resource.size(); }
+        [[nodiscard]] std::size_t position() const noexcept { return this->m_position; }
+        [[nodiscard]] bool eof() const noexcept { return this->m_position == this->size(); }
+
+    private:
+        Resource m_resource;
+        std::unique_ptr<impl::ReaderState> m_state;
+        std::size_t m_position = 0;
+    };
+
+    /* A file or directory yielded by romfs::entries() and romfs::walk() */
+    class Entry {
+    public:
+        constexpr Entry() = default;
+        constexpr Entry(std::string_view path, const Resource *resource) : m_path(path), m_resource(resource) {}
+
+        [[nodiscard]] constexpr std::string_view path() const noexcept { return m_path; }
+        [[nodiscard]] constexpr bool is_directory() const noexcept { return m_resource == nullptr; }
+
+        /* Must only be called on files */
+        [[nodiscard]] constexpr const Resource& resource() const noexcept { return *m_resource; }
+
+    private:
+        std::string_view m_path;
+        const Resource *m_resource = nullptr;
+    };
+
+    namespace impl {
+
+        /* Walks the generated tables in place: first the files of a directory, then its subdirectories */
+        class EntryIterator {
+        public:
+            using value_type = Entry;
+            using difference_type = std::ptrdiff_t;
+            using iterator_concept = std::forward_iterator_tag;
+
+            constexpr EntryIterator() = default;
+            constexpr EntryIterator(const ResourceLocation *resources, const DirectoryLocation *directories, std::uint32_t directory, bool recursive)
+                : m_resources(resources), m_directories(directories), m_directory(directory), m_end(directories[directory].directoryEnd),
+                  m_file(directories[directory].fileBegin), m_recursive(recursive) {
+                this->skip_exhausted_files();
+            }
+
+            [[nodiscard]] constexpr Entry operator*() const noexcept {
+                if (m_onDirectory)
+                    return { m_directories[m_directory].path, nullptr };
+                else
+                    return { m_resources[m_file].path, &m_resources[m_file].resource };
+            }
+
+            constexpr EntryIterator& operator++() noexcept {
+                if (!m_onDirectory) {
+                    m_file++;
+                    this->skip_exhausted_files();
+                } else if (m_recursive) {
+                    m_onDirectory = false;
+                    m_file = m_directories[m_directory].fileBegin;
+                    this->skip_exhausted_files();
+                } else {
+                    m_directory = m_directories[m_directory].directoryEnd;
+                }
+
+                return *this;
+            }
+
+            constexpr EntryIterator operator++(int) noexcept {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            [[nodiscard]] constexpr bool operator==(const EntryIterator &other) const noexcept {
+                if (*this == std::default_sentinel || other == std::default_sentinel)
+                    return *this == std::default_sentinel && other == std::default_sentinel;
+
+                return m_directory == other.m_directory && m_onDirectory == other.m_onDirectory && (m_onDirectory || m_file == other.m_file);
+            }
+
+            [[nodiscard]] constexpr bool operator==(std::default_sentinel_t) const noexcept {
+                return m_directory >= m_end;
+            }
+
+        private:
+            constexpr void skip_exhausted_files() noexcept {
+                if (m_file < m_directories[m_directory].fileEnd)
+                    return;
+
+                // Files only get visited for the starting directory unless walking recursively,
+                // either way the next entry is the directory that follows in the table
+                m_directory++;
+                m_onDirectory = true;
+            }
+
+            const ResourceLocation *m_resources = nullptr;
+            const DirectoryLocation *m_directories = nullptr;
+            std::uint32_t m_directory = 0, m_end = 0, m_file = 0;
+            bool m_onDirectory = false;
+            bool m_recursive = false;
+        };
+
+    }
+
+    /* Lazy, non-allocating range of romfs entries */
+    class EntryRange : public std::ranges::view_interface<EntryRange> {
+    public:
+        constexpr EntryRange() = default;
+        constexpr explicit EntryRange(impl::EntryIterator begin) : m_begin(begin) {}
+
+        [[nodiscard]] constexpr impl::EntryIterator begin() const noexcept { return m_begin; }
+        [[nodiscard]] constexpr std::default_sentinel_t end() const noexcept { return std::default_sentinel; }
+
+    private:
+        impl::EntryIterator m_begin;
+    };
+
+    namespace impl {
+
         [[nodiscard]] ROMFS_VISIBILITY const Resource& ROMFS_CONCAT(get_, LIBROMFS_PROJECT_NAME)(const fs::path &path);
+        [[nodiscard]] ROMFS_VISIBILITY const Resource& ROMFS_CONCAT(get_, LIBROMFS_PROJECT_NAME)(std::string_view path);
+        [[nodiscard]] ROMFS_VISIBILITY const Resource* ROMFS_CONCAT(find_, LIBROMFS_PROJECT_NAME)(std::string_view path) noexcept;
         [[nodiscard]] ROMFS_VISIBILITY std::vector<fs::path> ROMFS_CONCAT(list_, LIBROMFS_PROJECT_NAME)(const fs::path &path);
+        [[nodiscard]] ROMFS_VISIBILITY nonstd::span<const std::string_view> ROMFS_CONCAT(list_, LIBROMFS_PROJECT_NAME)(std::string_view path) noexcept;
+        [[nodiscard]] ROMFS_VISIBILITY EntryRange ROMFS_CONCAT(entries_, LIBROMFS_PROJECT_NAME)(std::string_view path, bool recursive) noexcept;
+        [[nodiscard]] ROMFS_VISIBILITY Reader ROMFS_CONCAT(open_, LIBROMFS_PROJECT_NAME)(const Resource &resource);
+        ROMFS_VISIBILITY void ROMFS_CONCAT(preload_, LIBROMFS_PROJECT_NAME)(const std::function<bool(std::string_view)> &predicate, std::size_t threadCount);
+        ROMFS_VISIBILITY void ROMFS_CONCAT(preload_, LIBROMFS_PROJECT_NAME)(std::string_view pattern, std::size_t threadCount);
+        [[nodiscard]] ROMFS_VISIBILITY std::shared_ptr<AsyncOperation> ROMFS_CONCAT(get_async_, LIBROMFS_PROJECT_NAME)(const Resource &resource);
+        ROMFS_VISIBILITY void ROMFS_CONCAT(set_executor_, LIBROMFS_PROJECT_NAME)(std::function<void(std::function<void()>)> executor);
+        ROMFS_VISIBILITY std::size_t ROMFS_CONCAT(trim_, LIBROMFS_PROJECT_NAME)(const std::function<bool(std::string_view)> &predicate);
+        ROMFS_VISIBILITY std::size_t ROMFS_CONCAT(trim_, LIBROMFS_PROJECT_NAME)(std::string_view pattern);
+        ROMFS_VISIBILITY void ROMFS_CONCAT(set_memory_resource_, LIBROMFS_PROJECT_NAME)(std::pmr::memory_resource *resource);
+        ROMFS_VISIBILITY void ROMFS_CONCAT(use_arena_, LIBROMFS_PROJECT_NAME)(bool hugePages);
+        ROMFS_VISIBILITY void ROMFS_CONCAT(set_cache_budget_, LIBROMFS_PROJECT_NAME)(std::size_t bytes);
+        [[nodiscard]] ROMFS_VISIBILITY CacheUsage ROMFS_CONCAT(cache_usage_, LIBROMFS_PROJECT_NAME)();
         [[nodiscard]] ROMFS_VISIBILITY std::string_view ROMFS_CONCAT(name_, LIBROMFS_PROJECT_NAME)();
 
     }
 
     [[nodiscard]] ROMFS_VISIBILITY inline const Resource& get(const fs::path &path) { return impl::ROMFS_CONCAT(get_, LIBROMFS_PROJECT_NAME)(path); }
     [[nodiscard]] ROMFS_VISIBILITY inline std::vector<fs::path> list(const fs::path &path = {}) { return impl::ROMFS_CONCAT(list_, LIBROMFS_PROJECT_NAME)(path); }
+
+    /* Lookups on plain strings. Paths are normalized while being compared, no fs::path is ever constructed */
+    /* find() and exists() never allocate or throw, a missing resource is reported as nullptr / false */
+    [[nodiscard]] ROMFS_VISIBILITY inline const Resource& get(std::string_view path) { return impl::ROMFS_CONCAT(get_, LIBROMFS_PROJECT_NAME)(path); }
+    [[nodiscard]] ROMFS_VISIBILITY inline const Resource& get(const char *path) { return get(std::string_view(path)); }
+    [[nodiscard]] ROMFS_VISIBILITY inline const Resource& get(const std::string &path) { return get(std::string_view(path)); }
+    [[nodiscard]] ROMFS_VISIBILITY inline const Resource* find(std::string_view path) noexcept { return impl::ROMFS_CONCAT(find_, LIBROMFS_PROJECT_NAME)(path); }
+    [[nodiscard]] ROMFS_VISIBILITY inline bool exists(std::string_view path) noexcept { return find(path) != nullptr; }
+    [[nodiscard]] ROMFS_VISIBILITY inline nonstd::span<const std::string_view> list(std::string_view path) noexcept { return impl::ROMFS_CONCAT(list_, LIBROMFS_PROJECT_NAME)(path); }
+
+    /* Files and subdirectories directly inside of path, or everything below it for walk() */
+    [[nodiscard]] ROMFS_VISIBILITY inline EntryRange entries(std::string_view path = {}) noexcept { return impl::ROMFS_CONCAT(entries_, LIBROMFS_PROJECT_NAME)(path, false); }
+    [[nodiscard]] ROMFS_VISIBILITY inline EntryRange walk(std::string_view path = {}) noexcept { return impl::ROMFS_CONCAT(entries_, LIBROMFS_PROJECT_NAME)(path, true); }
+
+    /* Streams a resource into caller supplied buffers, throws std::invalid_argument like get() if there's no such resource */
+    [[nodiscard]] ROMFS_VISIBILITY inline Reader open(const Resource &resource) { return impl::ROMFS_CONCAT(open_, LIBROMFS_PROJECT_NAME)(resource); }
+    [[nodiscard]] ROMFS_VISIBILITY inline Reader open(std::string_view path) { return open(get(path)); }
+
+    /* Decompresses every resource whose path matches in parallel and returns once all of them are cached. */
+    /* Patterns are globs, '*' matches within a directory and '**' across directories. threadCount 0 uses every core */
+    ROMFS_VISIBILITY inline void preload(const std::function<bool(std::string_view)> &predicate, std::size_t threadCount = 0) { impl::ROMFS_CONCAT(preload_, LIBROMFS_PROJECT_NAME)(predicate, threadCount); }
+    ROMFS_VISIBILITY inline void preload(std::string_view pattern = "**", std::size_t threadCount = 0) { impl::ROMFS_CONCAT(preload_, LIBROMFS_PROJECT_NAME)(pattern, threadCount); }
+
+    /* Decompresses a resource on the executor instead of the calling thread. Concurrent requests for the same */
+    /* resource share one decompression, resources that need no decompression are ready right away */
+    [[nodiscard]] ROMFS_VISIBILITY inline AsyncResource get_async(const Resource &resource) { return { resource, impl::ROMFS_CONCAT(get_async_, LIBROMFS_PROJECT_NAME)(resource) }; }
+    [[nodiscard]] ROMFS_VISIBILITY inline AsyncResource get_async(std::string_view path) { return get_async(get(path)); }
+
+    /* Runs the jobs of get_async(), an empty executor restores the default of a built-in thread pool */
+    ROMFS_VISIBILITY inline void set_executor(std::function<void(std::function<void()>)> executor) { impl::ROMFS_CONCAT(set_executor_, LIBROMFS_PROJECT_NAME)(std::move(executor)); }
+
+    /* Releases the decompressed data of every resource whose path matches, see Resource::release(). Returns the number of bytes freed */
+    ROMFS_VISIBILITY inline std::size_t trim(const std::function<bool(std::string_view)> &predicate) { return impl::ROMFS_CONCAT(trim_, LIBROMFS_PROJECT_NAME)(predicate); }
+    ROMFS_VISIBILITY inline std::size_t trim(std::string_view pattern = "**") { return impl::ROMFS_CONCAT(trim_, LIBROMFS_PROJECT_NAME)(pattern); }
+
+    /* Allocates decompressed data from resource from now on, nullptr restores the default of the global heap */
+    ROMFS_VISIBILITY inline void set_memory_resource(std::pmr::memory_resource *resource) { impl::ROMFS_CONCAT(set_memory_resource_, LIBROMFS_PROJECT_NAME)(resource); }
+
+    /* Places decompressed data into a single region reserved up front, large enough to hold every compressed */
+    /* resource at once. Each resource has a fixed place in it, evicting a resource gives its pages back to the system. */
+    /* Without mmap(), resources are allocated one by one from the memory resource set at the time of the first call instead */
+    ROMFS_VISIBILITY inline void use_arena(bool hugePages = false) { impl::ROMFS_CONCAT(use_arena_, LIBROMFS_PROJECT_NAME)(hugePages); }
+
+    /* Limits how many decompressed bytes are kept around, 0 means no limit (the default). Once over budget, */
+    /* the least recently used data that isn't pinned gets evicted and is decompressed again on its next use */
+    ROMFS_VISIBILITY inline void set_cache_budget(std::size_t bytes) { impl::ROMFS_CONCAT(set_cache_budget_, LIBROMFS_PROJECT_NAME)(bytes); }
+    /* How many bytes are held in decompressed form, and how many of them are pinned */
+    [[nodiscard]] ROMFS_VISIBILITY inline CacheUsage cache_usage() { return impl::ROMFS_CONCAT(cache_usage_, LIBROMFS_PROJECT_NAME)(); }
+
+    [[nodiscard]] ROMFS_VISIBILITY inline std::vector<fs::path> list(const char *path) { return list(fs::path(path)); }
+    [[nodiscard]] ROMFS_VISIBILITY inline std::vector<fs::path> list(const std::string &path) { return list(fs::path(path)); }
     [[nodiscard]] ROMFS_VISIBILITY inline std::string_view name() { return impl::ROMFS_CONCAT(name_, LIBROMFS_PROJECT_NAME)(); }
 
 }
\ No newline at end of file
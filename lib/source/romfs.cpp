@@ -1,91 +1,1274 @@
 #include <romfs/romfs.hpp>
 
+#include <array>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #define LIBROMFS_HAS_MMAN
+#endif
+
+#define LIBROMFS_CODEC_ZLIB 1
+#define LIBROMFS_CODEC_ZSTD 2
+#define LIBROMFS_CODEC_LZ4 3
+
+#if !defined(LIBROMFS_COMPRESSION_CODEC)
+    #define LIBROMFS_COMPRESSION_CODEC LIBROMFS_CODEC_ZLIB
+#endif
+
 #if defined(LIBROMFS_COMPRESS_RESOURCES)
-    #include <zlib.h>
+    #if LIBROMFS_COMPRESSION_CODEC == LIBROMFS_CODEC_ZSTD
+        #include <zstd.h>
+    #elif LIBROMFS_COMPRESSION_CODEC == LIBROMFS_CODEC_LZ4
+        #include <lz4.h>
+    #else
+        #include <zlib.h>
+        #if defined(LIBROMFS_USE_LIBDEFLATE)
+            #include <libdeflate.h>
+        #endif
+    #endif
 #endif
 
-nonstd::span<romfs::impl::ResourceLocation> ROMFS_CONCAT(ROMFS_NAME, _get_resources)();
-nonstd::span<std::string_view> ROMFS_CONCAT(ROMFS_NAME, _get_paths)();
+nonstd::span<const romfs::impl::ResourceLocation> ROMFS_CONCAT(ROMFS_NAME, _get_resources)();
+nonstd::span<const std::string_view> ROMFS_CONCAT(ROMFS_NAME, _get_paths)();
+nonstd::span<const std::int32_t> ROMFS_CONCAT(ROMFS_NAME, _get_hash_seeds)();
+nonstd::span<const std::uint32_t> ROMFS_CONCAT(ROMFS_NAME, _get_hash_slots)();
+nonstd::span<const romfs::impl::DirectoryLocation> ROMFS_CONCAT(ROMFS_NAME, _get_directories)();
+nonstd::span<const std::int32_t> ROMFS_CONCAT(ROMFS_NAME, _get_directory_hash_seeds)();
+nonstd::span<const std::uint32_t> ROMFS_CONCAT(ROMFS_NAME, _get_directory_hash_slots)();
 const char* ROMFS_CONCAT(ROMFS_NAME, _get_name)();
+#if defined(LIBROMFS_COMPRESS_RESOURCES)
+std::uint64_t ROMFS_CONCAT(ROMFS_NAME, _get_chunk_size)();
+std::uint64_t ROMFS_CONCAT(ROMFS_NAME, _get_decompressed_size)();
+#endif
+#if defined(LIBROMFS_COMPRESS_RESOURCES) && LIBROMFS_COMPRESSION_CODEC == LIBROMFS_CODEC_ZSTD
+nonstd::span<const std::uint8_t> ROMFS_CONCAT(ROMFS_NAME, _get_dictionary)();
+#endif
 
 namespace romfs {
 
-    ROMFS_VISIBILITY void impl::ROMFS_CONCAT(decompress_if_needed_, LIBROMFS_PROJECT_NAME)(std::vector<std::byte> &decompressedData, nonstd::span<const std::byte> compressedData) {
-        if (!decompressedData.empty() || compressedData.empty())
-            return;
+    namespace {
 
-        #if defined(LIBROMFS_COMPRESS_RESOURCES)
-            z_stream stream;
-            stream.zalloc = Z_NULL;
-            stream.zfree = Z_NULL;
-            stream.opaque = Z_NULL;
-            stream.avail_in = compressedData.size();
-            stream.next_in = const_cast<std::uint8_t*>(reinterpret_cast<const std::uint8_t*>(compressedData.data()));
-            stream.avail_out = 0x00;
+        constexpr bool is_separator(char c) noexcept {
+            #if defined(_WIN32)
+                return c == '/' || c == '\\';
+            #else
+                return c == '/';
+            #endif
+        }
+
+        // Calls callback with every component of path, skipping empty and "." components
+        // so "a//b", "./a/b" and "a/b/" all name the same resource as "a/b".
+        // Stops early as soon as callback returns false.
+        template<typename Callback>
+        bool for_each_component(std::string_view path, Callback &&callback) noexcept {
+            std::size_t begin = 0;
+            while (begin < path.size()) {
+                std::size_t end = begin;
+                while (end < path.size() && !is_separator(path[end]))
+                    end++;
+
+                auto component = path.substr(begin, end - begin);
+                if (!component.empty() && component != ".") {
+                    if (!callback(component))
+                        return false;
+                }
 
-            // Initialize the zlib inflate operation
-            if (inflateInit(&stream) != Z_OK) {
-                throw std::runtime_error("Failed to decompress romfs data!");
+                begin = end + 1;
             }
 
-            decompressedData.resize(compressedData.size() * 2); // Initial guess, adjust as needed
+            return true;
+        }
 
-            int ret;
-            do {
-                // Ensure enough space in the output buffer
-                if (stream.avail_out == 0) {
-                    decompressedData.resize(decompressedData.size() * 2);
-                    stream.avail_out = decompressedData.size() - stream.total_out;
-                    stream.next_out = reinterpret_cast<std::uint8_t*>(decompressedData.data()) + stream.total_out;
+        // FNV-1a over the normalized path, must be kept in sync with hashPath() in the generator
+        std::uint64_t hash_path(std::string_view path) noexcept {
+            std::uint64_t hash = 0xCBF29CE484222325;
+            bool first = true;
+
+            auto hashByte = [&hash](char c) {
+                hash ^= static_cast<std::uint8_t>(c);
+                hash *= 0x100000001B3;
+            };
+
+            for_each_component(path, [&](std::string_view component) {
+                if (!first)
+                    hashByte('/');
+                first = false;
+
+                for (char c : component)
+                    hashByte(c);
+
+                return true;
+            });
+
+            return hash;
+        }
+
+        std::uint64_t mix_seed(std::uint64_t hash, std::uint32_t seed) noexcept {
+            hash ^= seed * 0x9E3779B97F4A7C15;
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCD;
+            hash ^= hash >> 33;
+            hash *= 0xC4CEB93FE1A85EC9;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        // Compares a generated (already normalized) path against a user supplied one
+        bool path_equals(std::string_view resourcePath, std::string_view path) noexcept {
+            std::size_t offset = 0;
+            bool first = true;
+
+            bool matches = for_each_component(path, [&](std::string_view component) {
+                if (!first) {
+                    if (offset >= resourcePath.size() || resourcePath[offset] != '/')
+                        return false;
+                    offset++;
                 }
+                first = false;
+
+                if (resourcePath.substr(offset, component.size()) != component)
+                    return false;
+
+                offset += component.size();
+                return true;
+            });
+
+            return matches && offset == resourcePath.size();
+        }
+
+        // Returns the only table index path can possibly live at, the caller still has to compare the path
+        std::size_t lookup_index(nonstd::span<const std::int32_t> seeds, nonstd::span<const std::uint32_t> slots, std::string_view path) noexcept {
+            const auto hash = hash_path(path);
+            const auto seed = seeds[hash % seeds.size()];
+            const auto slot = seed < 0 ? std::size_t(-(seed + 1)) : std::size_t(mix_seed(hash, seed) % seeds.size());
+
+            return slots[slot];
+        }
+
+        const Resource* find_resource(std::string_view path) noexcept {
+            auto seeds = ROMFS_CONCAT(ROMFS_NAME, _get_hash_seeds)();
+            if (seeds.empty())
+                return nullptr;
 
-                // Perform the decompression
-                ret = inflate(&stream, Z_NO_FLUSH);
-                if (ret == Z_MEM_ERROR || ret == Z_DATA_ERROR) {
+            const auto &location = ROMFS_CONCAT(ROMFS_NAME, _get_resources)()[lookup_index(seeds, ROMFS_CONCAT(ROMFS_NAME, _get_hash_slots)(), path)];
+            if (!path_equals(location.path, path))
+                return nullptr;
+
+            return &location.resource;
+        }
+
+        const impl::DirectoryLocation* find_directory(std::string_view path) noexcept {
+            auto seeds = ROMFS_CONCAT(ROMFS_NAME, _get_directory_hash_seeds)();
+            if (seeds.empty())
+                return nullptr;
+
+            const auto &directory = ROMFS_CONCAT(ROMFS_NAME, _get_directories)()[lookup_index(seeds, ROMFS_CONCAT(ROMFS_NAME, _get_directory_hash_slots)(), path)];
+            if (!path_equals(directory.path, path))
+                return nullptr;
+
+            return &directory;
+        }
+
+        // Files directly inside of parent, or every file when parent is the root
+        nonstd::span<const std::string_view> list_directory(std::string_view parent) noexcept {
+            auto paths = ROMFS_CONCAT(ROMFS_NAME, _get_paths)();
+
+            if (for_each_component(parent, [](std::string_view) { return false; }))
+                return paths;
+
+            auto directory = find_directory(parent);
+            if (directory == nullptr)
+                return {};
+
+            return paths.subspan(directory->fileBegin, directory->fileEnd - directory->fileBegin);
+        }
+
+        // Matches path against a glob pattern. '*' and '?' stay within a path component, '**' spans
+        // any number of them and "**/" may also match no directory at all
+        bool match_glob(std::string_view pattern, std::string_view path) noexcept {
+            while (!pattern.empty()) {
+                if (pattern.starts_with("**")) {
+                    pattern.remove_prefix(2);
+                    if (pattern.starts_with('/') && match_glob(pattern.substr(1), path))
+                        return true;
+
+                    for (std::size_t i = 0; i <= path.size(); i++) {
+                        if (match_glob(pattern, path.substr(i)))
+                            return true;
+                    }
+
+                    return false;
+                }
+
+                if (pattern.front() == '*') {
+                    pattern.remove_prefix(1);
+                    for (std::size_t i = 0; i <= path.size(); i++) {
+                        if (match_glob(pattern, path.substr(i)))
+                            return true;
+                        if (i < path.size() && is_separator(path[i]))
+                            break;
+                    }
+
+                    return false;
+                }
+
+                if (path.empty())
+                    return false;
+                if (pattern.front() == '?' ? is_separator(path.front()) : pattern.front() != path.front())
+                    return false;
+
+                pattern.remove_prefix(1);
+                path.remove_prefix(1);
+            }
+
+            return path.empty();
+        }
+
+    }
+
+    namespace {
+
+        #if defined(LIBROMFS_COMPRESS_RESOURCES) && LIBROMFS_COMPRESSION_CODEC == LIBROMFS_CODEC_ZSTD
+
+            // The dictionary all resources have been compressed against, digested once on first use
+            const ZSTD_DDict* get_decompression_dictionary() {
+                static const auto dictionary = []() -> std::unique_ptr<ZSTD_DDict, decltype(&ZSTD_freeDDict)> {
+                    auto data = ROMFS_CONCAT(ROMFS_NAME, _get_dictionary)();
+                    if (data.empty())
+                        return { nullptr, ZSTD_freeDDict };
+
+                    return { ZSTD_createDDict(data.data(), data.size()), ZSTD_freeDDict };
+                }();
+
+                return dictionary.get();
+            }
+
+            // Decompresses compressedData into exactly decompressedSize bytes at output
+            void decompress(std::byte *output, std::size_t decompressedSize, nonstd::span<const std::byte> compressedData) {
+                thread_local std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context = { ZSTD_createDCtx(), ZSTD_freeDCtx };
+                if (context == nullptr) {
+                    throw std::runtime_error("Failed to decompress romfs data!");
+                }
+
+                std::size_t result;
+                if (auto dictionary = get_decompression_dictionary(); dictionary != nullptr)
+                    result = ZSTD_decompress_usingDDict(context.get(), output, decompressedSize, compressedData.data(), compressedData.size(), dictionary);
+                else
+                    result = ZSTD_decompressDCtx(context.get(), output, decompressedSize, compressedData.data(), compressedData.size());
+
+                if (ZSTD_isError(result) || result != decompressedSize) {
+                    throw std::runtime_error("Failed to decompress romfs data! ZSTD_decompress() failed");
+                }
+            }
+
+        #elif defined(LIBROMFS_COMPRESS_RESOURCES) && LIBROMFS_COMPRESSION_CODEC == LIBROMFS_CODEC_LZ4
+
+            // Decompresses compressedData into exactly decompressedSize bytes at output
+            void decompress(std::byte *output, std::size_t decompressedSize, nonstd::span<const std::byte> compressedData) {
+                auto result = LZ4_decompress_safe(reinterpret_cast<const char*>(compressedData.data()), reinterpret_cast<char*>(output), static_cast<int>(compressedData.size()), static_cast<int>(decompressedSize));
+
+                if (result < 0 || std::size_t(result) != decompressedSize) {
+                    throw std::runtime_error("Failed to decompress romfs data! LZ4_decompress_safe() failed");
+                }
+            }
+
+        #elif defined(LIBROMFS_COMPRESS_RESOURCES) && defined(LIBROMFS_USE_LIBDEFLATE)
+
+            // Decompresses compressedData into exactly decompressedSize bytes at output. The whole input is in memory
+            // and its size is known, so libdeflate decodes it in one go without zlib's streaming bookkeeping
+            void decompress(std::byte *output, std::size_t decompressedSize, nonstd::span<const std::byte> compressedData) {
+                thread_local std::unique_ptr<libdeflate_decompressor, decltype(&libdeflate_free_decompressor)> decompressor = { libdeflate_alloc_decompressor(), libdeflate_free_decompressor };
+                if (decompressor == nullptr) {
+                    throw std::runtime_error("Failed to decompress romfs data!");
+                }
+
+                // Passing no actual size makes anything but exactly decompressedSize bytes of output an error
+                #if defined(LIBROMFS_SKIP_CHECKSUMS)
+                    // Skip the 2 byte zlib header and the adler32 trailer, the data has been verified when embedding it
+                    constexpr std::size_t HeaderSize = 2, TrailerSize = 4;
+                    if (compressedData.size() < HeaderSize + TrailerSize) {
+                        throw std::runtime_error("Failed to decompress romfs data! libdeflate failed");
+                    }
+
+                    auto deflateData = compressedData.subspan(HeaderSize, compressedData.size() - HeaderSize - TrailerSize);
+                    auto result = libdeflate_deflate_decompress(decompressor.get(), deflateData.data(), deflateData.size(), output, decompressedSize, nullptr);
+                #else
+                    auto result = libdeflate_zlib_decompress(decompressor.get(), compressedData.data(), compressedData.size(), output, decompressedSize, nullptr);
+                #endif
+
+                if (result != LIBDEFLATE_SUCCESS) {
+                    throw std::runtime_error("Failed to decompress romfs data! libdeflate failed");
+                }
+            }
+
+        #else
+
+            // Decompresses compressedData into exactly decompressedSize bytes at output
+            void decompress(std::byte *output, std::size_t decompressedSize, nonstd::span<const std::byte> compressedData) {
+                #if defined(LIBROMFS_COMPRESS_RESOURCES)
+                    z_stream stream;
+                    stream.zalloc = Z_NULL;
+                    stream.zfree = Z_NULL;
+                    stream.opaque = Z_NULL;
+                    stream.avail_in = compressedData.size();
+                    stream.next_in = const_cast<std::uint8_t*>(reinterpret_cast<const std::uint8_t*>(compressedData.data()));
+
+                    // Initialize the zlib inflate operation
+                    if (inflateInit(&stream) != Z_OK) {
+                        throw std::runtime_error("Failed to decompress romfs data!");
+                    }
+
+                    // The size is known up front so the whole stream can be inflated in a single pass,
+                    // straight into the caller's buffer without any slack behind it
+                    stream.avail_out = decompressedSize;
+                    stream.next_out = reinterpret_cast<std::uint8_t*>(output);
+
+                    auto ret = inflate(&stream, Z_FINISH);
                     inflateEnd(&stream);
-                    throw std::runtime_error("Failed to decompress romfs data! inflate() failed");
+
+                    if (ret != Z_STREAM_END || stream.total_out != decompressedSize) {
+                        throw std::runtime_error("Failed to decompress romfs data! inflate() failed");
+                    }
+                #else
+                    std::ignore = output;
+                    std::ignore = decompressedSize;
+                    std::ignore = compressedData;
+                #endif
+            }
+
+        #endif
+
+    }
+
+    struct impl::ResourceAccess {
+        static nonstd::span<const std::byte> compressedData(const Resource &resource) { return { reinterpret_cast<const std::byte*>(resource.m_compressedData.data()), resource.m_compressedData.size() }; }
+        static ResourceState &state(const Resource &resource) { return *resource.m_state; }
+        static nonstd::span<const std::uint64_t> chunkOffsets(const Resource &resource) { return resource.m_chunkOffsets; }
+        /* Solid block the resource lives in and where inside of it, nullptr for resources compressed on their own */
+        static const Resource* block(const Resource &resource) { return resource.m_block; }
+        static std::size_t offset(const Resource &resource) { return resource.m_offset; }
+    };
+
+    namespace {
+
+        // Compressed resources are split into chunks of the same decompressed size, except for the last one.
+        // Resources without a chunk offset table consist of a single chunk spanning the whole resource
+        std::size_t chunk_size(const Resource &resource) {
+            #if defined(LIBROMFS_COMPRESS_RESOURCES)
+                if (!impl::ResourceAccess::chunkOffsets(resource).empty())
+                    return ROMFS_CONCAT(ROMFS_NAME, _get_chunk_size)();
+            #endif
+
+            return resource.size();
+        }
+
+        std::size_t chunk_count(const Resource &resource) {
+            auto offsets = impl::ResourceAccess::chunkOffsets(resource);
+            return offsets.empty() ? 1 : offsets.size() - 1;
+        }
+
+        nonstd::span<const std::byte> compressed_chunk(const Resource &resource, std::size_t index) {
+            auto data = impl::ResourceAccess::compressedData(resource);
+            auto offsets = impl::ResourceAccess::chunkOffsets(resource);
+            if (offsets.empty())
+                return data;
+
+            return data.subspan(offsets[index], offsets[index + 1] - offsets[index]);
+        }
+
+    }
+
+    namespace {
+
+        #if defined(LIBROMFS_COMPRESS_RESOURCES) && LIBROMFS_COMPRESSION_CODEC == LIBROMFS_CODEC_ZSTD
+
+            // Every chunk is a separate frame and frames are stored back to back, so one stream decodes them all in order
+            class StreamReaderState : public impl::ReaderState {
+            public:
+                explicit StreamReaderState(const Resource &resource) : m_input(impl::ResourceAccess::compressedData(resource)) {
+                    if (this->m_context == nullptr)
+                        throw std::runtime_error("Failed to decompress romfs data!");
+
+                    ZSTD_DCtx_refDDict(this->m_context.get(), get_decompression_dictionary());
+                }
+
+                std::size_t read(nonstd::span<std::byte> buffer) override {
+                    ZSTD_outBuffer output = { buffer.data(), buffer.size(), 0 };
+                    ZSTD_inBuffer input = { this->m_input.data(), this->m_input.size(), this->m_inputPosition };
+
+                    while (output.pos < output.size) {
+                        const auto previousPosition = output.pos + input.pos;
+                        auto result = ZSTD_decompressStream(this->m_context.get(), &output, &input);
+                        if (ZSTD_isError(result))
+                            throw std::runtime_error("Failed to decompress romfs data! ZSTD_decompressStream() failed");
+
+                        // The last frame has been decoded entirely
+                        if (result == 0 && input.pos == input.size)
+                            break;
+
+                        if (output.pos + input.pos == previousPosition)
+                            throw std::runtime_error("Failed to decompress romfs data! ZSTD_decompressStream() failed");
+                    }
+
+                    this->m_inputPosition = input.pos;
+                    return output.pos;
+                }
+
+            private:
+                std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> m_context = { ZSTD_createDCtx(), ZSTD_freeDCtx };
+                nonstd::span<const std::byte> m_input;
+                std::size_t m_inputPosition = 0;
+            };
+
+        #elif defined(LIBROMFS_COMPRESS_RESOURCES) && LIBROMFS_COMPRESSION_CODEC == LIBROMFS_CODEC_LZ4
+
+            // Raw LZ4 blocks can't be decoded partially, so every chunk is decoded whole and then handed out piece by piece
+            class StreamReaderState : public impl::ReaderState {
+            public:
+                explicit StreamReaderState(const Resource &resource) : m_resource(resource) {}
+
+                std::size_t read(nonstd::span<std::byte> buffer) override {
+                    const auto requested = buffer.size();
+                    while (!buffer.empty()) {
+                        if (this->m_bufferPosition == this->m_buffer.size()) {
+                            if (this->m_chunk >= chunk_count(this->m_resource))
+                                break;
+
+                            const auto chunkSize = chunk_size(this->m_resource);
+                            this->m_buffer.resize(std::min(chunkSize, this->m_resource.size() - this->m_chunk * chunkSize));
+                            decompress(this->m_buffer.data(), this->m_buffer.size(), compressed_chunk(this->m_resource, this->m_chunk));
+
+                            this->m_chunk++;
+                            this->m_bufferPosition = 0;
+                        }
+
+                        const auto length = std::min(buffer.size(), this->m_buffer.size() - this->m_bufferPosition);
+                        std::memcpy(buffer.data(), this->m_buffer.data() + this->m_bufferPosition, length);
+
+                        this->m_bufferPosition += length;
+                        buffer = buffer.subspan(length);
+                    }
+
+                    return requested - buffer.size();
+                }
+
+            private:
+                Resource m_resource;
+                std::vector<std::byte> m_buffer;
+                std::size_t m_bufferPosition = 0;
+                std::size_t m_chunk = 0;
+            };
+
+        #elif defined(LIBROMFS_COMPRESS_RESOURCES)
+
+            // Inflates straight into the caller's buffer, restarting the stream at every chunk boundary
+            class StreamReaderState : public impl::ReaderState {
+            public:
+                explicit StreamReaderState(const Resource &resource) : m_resource(resource) {
+                    this->m_stream.zalloc = Z_NULL;
+                    this->m_stream.zfree = Z_NULL;
+                    this->m_stream.opaque = Z_NULL;
+                    this->set_input(compressed_chunk(resource, 0));
+
+                    if (inflateInit(&this->m_stream) != Z_OK) {
+                        throw std::runtime_error("Failed to decompress romfs data!");
+                    }
+                }
+
+                ~StreamReaderState() override {
+                    inflateEnd(&this->m_stream);
+                }
+
+                std::size_t read(nonstd::span<std::byte> buffer) override {
+                    std::size_t produced = 0;
+                    while (produced < buffer.size()) {
+                        if (this->m_chunkFinished) {
+                            // The stream ends along with the last chunk
+                            if (this->m_chunk + 1 >= chunk_count(this->m_resource))
+                                break;
+
+                            if (inflateReset(&this->m_stream) != Z_OK) {
+                                throw std::runtime_error("Failed to decompress romfs data! inflate() failed");
+                            }
+
+                            this->set_input(compressed_chunk(this->m_resource, ++this->m_chunk));
+                            this->m_chunkFinished = false;
+                        }
+
+                        // zlib only counts in uInt, so anything larger is fed to it and inflated into in slices
+                        if (this->m_stream.avail_in == 0 && !this->m_input.empty()) {
+                            const auto length = std::min<std::size_t>(this->m_input.size(), std::numeric_limits<uInt>::max());
+                            this->m_stream.avail_in = static_cast<uInt>(length);
+                            this->m_stream.next_in = const_cast<std::uint8_t*>(reinterpret_cast<const std::uint8_t*>(this->m_input.data()));
+                            this->m_input = this->m_input.subspan(length);
+                        }
+
+                        const auto slice = std::min<std::size_t>(buffer.size() - produced, std::numeric_limits<uInt>::max());
+                        this->m_stream.avail_out = static_cast<uInt>(slice);
+                        this->m_stream.next_out = reinterpret_cast<std::uint8_t*>(buffer.data() + produced);
+
+                        auto ret = inflate(&this->m_stream, Z_NO_FLUSH);
+                        produced += slice - this->m_stream.avail_out;
+
+                        if (ret == Z_STREAM_END)
+                            this->m_chunkFinished = true;
+                        else if (ret != Z_OK) {
+                            throw std::runtime_error("Failed to decompress romfs data! inflate() failed");
+                        }
+                    }
+
+                    return produced;
+                }
+
+            private:
+                void set_input(nonstd::span<const std::byte> input) {
+                    this->m_input = input;
+                    this->m_stream.avail_in = 0;
+                    this->m_stream.next_in = Z_NULL;
                 }
-            } while (ret != Z_STREAM_END);
 
-            // Resize the output buffer to the actual size
-            decompressedData.resize(stream.total_out);
+                Resource m_resource;
+                nonstd::span<const std::byte> m_input;
+                z_stream m_stream;
+                std::size_t m_chunk = 0;
+                bool m_chunkFinished = false;
+            };
+
+        #endif
+
+    }
+
+    namespace {
+
+        std::size_t decompressed_size(const Resource &resource) {
+            return resource.size() + 1;
+        }
+
+        // One region holding the decompressed data of every compressed resource at the offset the generator assigned
+        // to it. The address space is reserved up front, pages only get committed once something is decompressed into them.
+        // Without mmap() nothing can be reserved without committing it right away, so every resource is allocated from upstream instead
+        class Arena : public std::pmr::memory_resource {
+        public:
+            Arena([[maybe_unused]] std::size_t size, bool hugePages, [[maybe_unused]] std::pmr::memory_resource *upstream) {
+                #if defined(LIBROMFS_HAS_MMAN)
+                    this->m_size = std::max<std::size_t>(size, 1);
+
+                    // Huge pages need 2 MiB aligned memory, so reserve enough to align the region ourselves
+                    const std::size_t alignment = hugePages ? HugePageSize : 1;
+                    this->m_mappingSize = this->m_size + alignment - 1;
+
+                    this->m_mapping = ::mmap(nullptr, this->m_mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+                    if (this->m_mapping == MAP_FAILED)
+                        throw std::bad_alloc();
+
+                    this->m_base = reinterpret_cast<std::byte*>((reinterpret_cast<std::uintptr_t>(this->m_mapping) + alignment - 1) & ~(alignment - 1));
+
+                    #if defined(MADV_HUGEPAGE)
+                        if (hugePages)
+                            ::madvise(this->m_base, this->m_size, MADV_HUGEPAGE);
+                    #endif
+                #else
+                    std::ignore = hugePages;
+                    this->m_upstream = upstream;
+                #endif
+            }
+
+            ~Arena() override {
+                #if defined(LIBROMFS_HAS_MMAN)
+                    ::munmap(this->m_mapping, this->m_mappingSize);
+                #endif
+            }
+
+            std::byte* slot(const Resource &resource) {
+                #if defined(LIBROMFS_HAS_MMAN)
+                    return this->m_base + impl::ResourceAccess::state(resource).arenaOffset;
+                #else
+                    return static_cast<std::byte*>(this->m_upstream->allocate(decompressed_size(resource), alignof(std::max_align_t)));
+                #endif
+            }
+
+        private:
+            static constexpr std::size_t HugePageSize = 2 * 1024 * 1024;
+
+            void* do_allocate(std::size_t, std::size_t) override {
+                // Resources always go into their slot, nothing else gets allocated from the arena
+                throw std::bad_alloc();
+            }
+
+            void do_deallocate([[maybe_unused]] void *pointer, [[maybe_unused]] std::size_t bytes, [[maybe_unused]] std::size_t alignment) override {
+                // Hand the pages that lie entirely within the slot back to the system, the address range stays reserved
+                #if defined(LIBROMFS_HAS_MMAN) && defined(MADV_DONTNEED)
+                    const auto pageSize = std::uintptr_t(::sysconf(_SC_PAGESIZE));
+                    const auto begin = (reinterpret_cast<std::uintptr_t>(pointer) + pageSize - 1) & ~(pageSize - 1);
+                    const auto end = (reinterpret_cast<std::uintptr_t>(pointer) + bytes) & ~(pageSize - 1);
+                    if (begin < end)
+                        ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+                #elif !defined(LIBROMFS_HAS_MMAN)
+                    this->m_upstream->deallocate(pointer, bytes, alignment);
+                #endif
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+                return this == &other;
+            }
+
+            #if defined(LIBROMFS_HAS_MMAN)
+                std::size_t m_size = 0;
+                std::byte *m_base = nullptr;
+                void *m_mapping = nullptr;
+                std::size_t m_mappingSize = 0;
+            #else
+                std::pmr::memory_resource *m_upstream = nullptr;
+            #endif
+        };
+
+        struct Allocation {
+            std::mutex mutex;
+            std::atomic<std::pmr::memory_resource*> resource = std::pmr::new_delete_resource();
+            std::unique_ptr<Arena> arena;
+        };
+
+        Allocation& get_allocation() {
+            static Allocation allocation;
+            return allocation;
+        }
+
+        void allocate_data(const Resource &resource) {
+            auto &state = impl::ResourceAccess::state(resource);
+            auto &allocation = get_allocation();
+
+            auto allocator = allocation.resource.load(std::memory_order_acquire);
+            if (auto arena = dynamic_cast<Arena*>(allocator); arena != nullptr)
+                state.data.store(arena->slot(resource), std::memory_order_relaxed);
+            else
+                state.data.store(static_cast<std::byte*>(allocator->allocate(decompressed_size(resource), alignof(std::max_align_t))), std::memory_order_relaxed);
+            state.allocator = allocator;
+        }
+
+        void deallocate_data(const Resource &resource) {
+            auto &state = impl::ResourceAccess::state(resource);
+            // Cleared before freeing, so data() stops handing out the pointer as early as possible
+            if (auto data = state.data.exchange(nullptr, std::memory_order_acq_rel); data != nullptr)
+                state.allocator->deallocate(data, decompressed_size(resource), alignof(std::max_align_t));
+
+            state.allocator = nullptr;
+        }
+
+    }
+
+    ROMFS_VISIBILITY void impl::ROMFS_CONCAT(set_memory_resource_, LIBROMFS_PROJECT_NAME)(std::pmr::memory_resource *resource) {
+        get_allocation().resource.store(resource == nullptr ? std::pmr::new_delete_resource() : resource, std::memory_order_release);
+    }
+
+    ROMFS_VISIBILITY void impl::ROMFS_CONCAT(use_arena_, LIBROMFS_PROJECT_NAME)(bool hugePages) {
+        #if defined(LIBROMFS_COMPRESS_RESOURCES)
+            auto &allocation = get_allocation();
+            std::scoped_lock lock(allocation.mutex);
 
-            // Clean up
-            inflateEnd(&stream);
+            // Data may still live in an existing arena, so it's only ever created once
+            if (allocation.arena == nullptr)
+                allocation.arena = std::make_unique<Arena>(ROMFS_CONCAT(ROMFS_NAME, _get_decompressed_size)(), hugePages, allocation.resource.load(std::memory_order_acquire));
+
+            allocation.resource.store(allocation.arena.get(), std::memory_order_release);
         #else
-            std::ignore = compressedData;
-            std::ignore = decompressedData;
+            std::ignore = hugePages;
         #endif
     }
 
+    namespace {
 
-    ROMFS_VISIBILITY const romfs::Resource &impl::ROMFS_CONCAT(get_, LIBROMFS_PROJECT_NAME)(const fs::path &path) {
-        for (const auto &[resourcePath, resourceData] : ROMFS_CONCAT(ROMFS_NAME, _get_resources)()) {
-            if (path == fs::path(resourcePath))
-                return resourceData;
+        // Every resource that currently holds decompressed data, swept by a CLOCK hand once over budget.
+        // Data pinned forever can't be evicted by the sweep, so it doesn't count against the budget either
+        struct Cache {
+            std::mutex mutex;
+            std::vector<Resource> resident;
+            std::size_t hand = 0;
+            std::atomic<std::size_t> used = 0;
+            std::atomic<std::size_t> pinnedForever = 0;
+            std::atomic<std::size_t> budget = 0;
+        };
+
+        Cache& get_cache() {
+            static Cache cache;
+            return cache;
+        }
+
+        // Frees the data of cache.resident[index] unless it's pinned. Data pinned forever by data() only gets freed
+        // when explicitly released. Claiming the data for eviction makes concurrent pin attempts wait. Expects cache.mutex to be held
+        bool evict(Cache &cache, std::size_t index, bool releaseForever) {
+            auto resource = cache.resident[index];
+            auto &state = impl::ResourceAccess::state(resource);
+
+            auto status = state.status.load(std::memory_order_relaxed);
+            do {
+                if ((status & impl::ResourceState::StatusMask) != impl::ResourceState::Ready)
+                    return false;
+                if ((status & ~(impl::ResourceState::StatusMask | impl::ResourceState::PinnedForever)) != 0)
+                    return false;
+                if ((status & impl::ResourceState::PinnedForever) && !releaseForever)
+                    return false;
+            } while (!state.status.compare_exchange_weak(status, impl::ResourceState::Evicting, std::memory_order_acquire));
+
+            deallocate_data(resource);
+            state.status.store(impl::ResourceState::Empty, std::memory_order_release);
+            state.status.notify_all();
+
+            if (status & impl::ResourceState::PinnedForever)
+                cache.pinnedForever.fetch_sub(decompressed_size(resource), std::memory_order_relaxed);
+            cache.used.fetch_sub(decompressed_size(resource), std::memory_order_relaxed);
+            cache.resident[index] = cache.resident.back();
+            cache.resident.pop_back();
+
+            return true;
+        }
+
+        // Only data the sweep could actually evict counts against the budget. The counters are updated independently
+        // of each other, but wrap around consistently, so the difference is never off for longer than an update
+        bool over_budget(const Cache &cache) {
+            const auto budget = cache.budget.load(std::memory_order_relaxed);
+            return budget != 0 && cache.used.load(std::memory_order_relaxed) - cache.pinnedForever.load(std::memory_order_relaxed) > budget;
+        }
+
+        // Evicts unpinned data until the cache fits into its budget again. Recently pinned data gets a second
+        // chance, so two full sweeps are enough to find everything that can be evicted. Evicting moves the last
+        // resident resource under the hand, so only moving on counts as a visit. Expects cache.mutex to be held
+        void trim_cache(Cache &cache) {
+            const auto sweep = 2 * cache.resident.size();
+            for (std::size_t visited = 0; visited < sweep && !cache.resident.empty() && over_budget(cache);) {
+                if (cache.hand >= cache.resident.size())
+                    cache.hand = 0;
+
+                auto &state = impl::ResourceAccess::state(cache.resident[cache.hand]);
+                if (state.referenced.exchange(false, std::memory_order_relaxed) || !evict(cache, cache.hand, false)) {
+                    cache.hand++;
+                    visited++;
+                }
+            }
+        }
+
+        // Frees the data of every resident resource selected by predicate that isn't pinned, returns the number of bytes freed
+        template<typename Predicate>
+        std::size_t release_resident(Predicate &&predicate) {
+            auto &cache = get_cache();
+            std::scoped_lock lock(cache.mutex);
+
+            const auto usedBefore = cache.used.load(std::memory_order_relaxed);
+            for (std::size_t index = 0; index < cache.resident.size();) {
+                // Evicting moves the last resident resource into this index, so look at it again
+                if (!predicate(impl::ResourceAccess::state(cache.resident[index])) || !evict(cache, index, true))
+                    index++;
+            }
+
+            return usedBefore - cache.used.load(std::memory_order_relaxed);
+        }
+
+        std::size_t trim_resources(const std::function<bool(std::string_view)> &predicate) {
+            std::vector<const impl::ResourceState*> selected;
+            for (const auto &[path, resource] : ROMFS_CONCAT(ROMFS_NAME, _get_resources)()) {
+                if (resource.compressed() && predicate(path))
+                    selected.push_back(&impl::ResourceAccess::state(resource));
+            }
+            std::sort(selected.begin(), selected.end());
+
+            return release_resident([&](const impl::ResourceState &state) { return std::binary_search(selected.begin(), selected.end(), &state); });
+        }
+
+        void trim_cache_if_over_budget() {
+            auto &cache = get_cache();
+            if (!over_budget(cache))
+                return;
+
+            std::scoped_lock lock(cache.mutex);
+            trim_cache(cache);
+        }
+
+        // Pins the data of a resource if it's currently decompressed, without decompressing it otherwise
+        const std::byte* try_pin(const Resource &resource, std::uint32_t status, bool forever) {
+            auto &state = impl::ResourceAccess::state(resource);
+            while ((status & impl::ResourceState::StatusMask) == impl::ResourceState::Ready) {
+                const auto pinned = forever ? (status | impl::ResourceState::PinnedForever) : (status + impl::ResourceState::OnePin);
+                if (state.status.compare_exchange_weak(status, pinned, std::memory_order_acquire)) {
+                    if (forever && !(status & impl::ResourceState::PinnedForever))
+                        get_cache().pinnedForever.fetch_add(decompressed_size(resource), std::memory_order_relaxed);
+
+                    state.referenced.store(true, std::memory_order_relaxed);
+                    return state.data.load(std::memory_order_relaxed);
+                }
+            }
+
+            return nullptr;
         }
 
-        throw std::invalid_argument(std::string("Invalid romfs resource path for '") + std::string(romfs::name()) + "' : " + path.string());
     }
 
-    ROMFS_VISIBILITY std::vector<fs::path> impl::ROMFS_CONCAT(list_, LIBROMFS_PROJECT_NAME)(const fs::path &parent) {
-        if (parent.empty()) {
-            std::vector<fs::path> result;
-            for (const auto &pathString : ROMFS_CONCAT(ROMFS_NAME, _get_paths)()) {
-                result.emplace_back(pathString);
+    ROMFS_VISIBILITY const std::byte* impl::ROMFS_CONCAT(pin_, LIBROMFS_PROJECT_NAME)(const Resource &resource, bool forever) {
+        // Resources inside of a solid block are served straight from the block's data
+        if (auto block = ResourceAccess::block(resource); block != nullptr)
+            return ROMFS_CONCAT(pin_, LIBROMFS_PROJECT_NAME)(*block, forever) + ResourceAccess::offset(resource);
+
+        auto &state = ResourceAccess::state(resource);
+        const auto size = resource.size();
+
+        auto status = state.status.load(std::memory_order_acquire);
+        while (true) {
+            if (auto data = try_pin(resource, status, forever); data != nullptr)
+                return data;
+
+            status = state.status.load(std::memory_order_acquire);
+            if (status == ResourceState::Decompressing || status == ResourceState::Evicting) {
+                state.status.wait(status, std::memory_order_acquire);
+                status = state.status.load(std::memory_order_acquire);
+                continue;
             }
-            return result;
-        } else {
-            std::vector<fs::path> result;
-            for (const auto &pathString : ROMFS_CONCAT(ROMFS_NAME, _get_paths)()) {
-                auto path = fs::path(pathString);
-                if (path.parent_path() == parent)
-                    result.push_back(path);
+
+            if (status != ResourceState::Empty || !state.status.compare_exchange_weak(status, ResourceState::Decompressing, std::memory_order_acquire))
+                continue;
+
+            try {
+                // Allocate once for the whole resource plus the null terminator uncompressed resources carry as well
+                allocate_data(resource);
+                auto data = state.data.load(std::memory_order_relaxed);
+
+                const auto chunkSize = chunk_size(resource);
+                for (std::size_t index = 0; index < chunk_count(resource); index++) {
+                    const auto offset = index * chunkSize;
+                    decompress(data + offset, std::min(chunkSize, size - offset), compressed_chunk(resource, index));
+                }
+
+                data[size] = std::byte(0x00);
+            } catch (...) {
+                deallocate_data(resource);
+                state.status.store(ResourceState::Empty, std::memory_order_release);
+                state.status.notify_all();
+                throw;
             }
-            return result;
+
+            // Hand out the data pinned already, so it can't be evicted before the caller got to use it
+            auto data = state.data.load(std::memory_order_relaxed);
+            state.referenced.store(true, std::memory_order_relaxed);
+            state.status.store(ResourceState::Ready | (forever ? ResourceState::PinnedForever : ResourceState::OnePin), std::memory_order_release);
+            state.status.notify_all();
+
+            auto &cache = get_cache();
+            std::scoped_lock lock(cache.mutex);
+            cache.resident.push_back(resource);
+            cache.used.fetch_add(decompressed_size(resource), std::memory_order_relaxed);
+            if (forever)
+                cache.pinnedForever.fetch_add(decompressed_size(resource), std::memory_order_relaxed);
+            trim_cache(cache);
+
+            return data;
         }
     }
 
+    ROMFS_VISIBILITY void impl::ROMFS_CONCAT(unpin_, LIBROMFS_PROJECT_NAME)(const Resource &resource) noexcept {
+        if (auto block = ResourceAccess::block(resource); block != nullptr)
+            return ROMFS_CONCAT(unpin_, LIBROMFS_PROJECT_NAME)(*block);
+
+        ResourceAccess::state(resource).status.fetch_sub(ResourceState::OnePin, std::memory_order_release);
+        trim_cache_if_over_budget();
+    }
+
+    ROMFS_VISIBILITY bool impl::ROMFS_CONCAT(release_, LIBROMFS_PROJECT_NAME)(const Resource &resource) {
+        if (!resource.compressed())
+            return false;
+
+        return release_resident([&](const ResourceState &state) { return &state == &ResourceAccess::state(resource); }) != 0;
+    }
+
+    ROMFS_VISIBILITY std::size_t impl::ROMFS_CONCAT(trim_, LIBROMFS_PROJECT_NAME)(const std::function<bool(std::string_view)> &predicate) {
+        return trim_resources(predicate);
+    }
+
+    ROMFS_VISIBILITY std::size_t impl::ROMFS_CONCAT(trim_, LIBROMFS_PROJECT_NAME)(std::string_view pattern) {
+        return trim_resources([pattern](std::string_view path) { return match_glob(pattern, path); });
+    }
+
+    ROMFS_VISIBILITY void impl::ROMFS_CONCAT(set_cache_budget_, LIBROMFS_PROJECT_NAME)(std::size_t bytes) {
+        auto &cache = get_cache();
+        std::scoped_lock lock(cache.mutex);
+
+        cache.budget.store(bytes, std::memory_order_relaxed);
+        trim_cache(cache);
+    }
+
+    ROMFS_VISIBILITY CacheUsage impl::ROMFS_CONCAT(cache_usage_, LIBROMFS_PROJECT_NAME)() {
+        auto &cache = get_cache();
+        std::scoped_lock lock(cache.mutex);
+
+        CacheUsage usage = { cache.used.load(std::memory_order_relaxed), 0, cache.budget.load(std::memory_order_relaxed) };
+        for (const auto &resource : cache.resident) {
+            if (ResourceAccess::state(resource).status.load(std::memory_order_relaxed) & ~ResourceState::StatusMask)
+                usage.pinned += decompressed_size(resource);
+        }
+
+        return usage;
+    }
+
+    namespace {
+
+        // Range of work items owned by one preload worker. The owner takes items from the front,
+        // idle workers steal from the back. Both ends share one word so either side claims an item with a single CAS
+        class WorkRange {
+        public:
+            void assign(std::uint32_t begin, std::uint32_t end) noexcept {
+                this->m_range.store(pack(begin, end), std::memory_order_relaxed);
+            }
+
+            std::optional<std::uint32_t> pop_front() noexcept {
+                auto range = this->m_range.load(std::memory_order_relaxed);
+                while (begin(range) < end(range)) {
+                    if (this->m_range.compare_exchange_weak(range, pack(begin(range) + 1, end(range)), std::memory_order_relaxed))
+                        return begin(range);
+                }
+
+                return std::nullopt;
+            }
+
+            std::optional<std::uint32_t> steal_back() noexcept {
+                auto range = this->m_range.load(std::memory_order_relaxed);
+                while (begin(range) < end(range)) {
+                    if (this->m_range.compare_exchange_weak(range, pack(begin(range), end(range) - 1), std::memory_order_relaxed))
+                        return end(range) - 1;
+                }
+
+                return std::nullopt;
+            }
+
+        private:
+            static constexpr std::uint64_t pack(std::uint32_t begin, std::uint32_t end) noexcept { return (std::uint64_t(begin) << 32) | end; }
+            static constexpr std::uint32_t begin(std::uint64_t range) noexcept { return std::uint32_t(range >> 32); }
+            static constexpr std::uint32_t end(std::uint64_t range) noexcept { return std::uint32_t(range); }
+
+            alignas(64) std::atomic<std::uint64_t> m_range = 0;
+        };
+
+        void preload_resources(const std::function<bool(std::string_view)> &predicate, std::size_t threadCount) {
+            std::vector<const Resource*> selected;
+            for (const auto &[path, resource] : ROMFS_CONCAT(ROMFS_NAME, _get_resources)()) {
+                if (predicate(path) && resource.compressed())
+                    selected.push_back(&resource);
+            }
+
+            if (threadCount == 0)
+                threadCount = std::max(1U, std::thread::hardware_concurrency());
+            threadCount = std::clamp<std::size_t>(threadCount, 1, std::max<std::size_t>(selected.size(), 1));
+
+            // Hand every worker an equal share up front, whoever runs out early helps out the others
+            std::vector<WorkRange> ranges(threadCount);
+            for (std::size_t i = 0; i < threadCount; i++)
+                ranges[i].assign(std::uint32_t(selected.size() * i / threadCount), std::uint32_t(selected.size() * (i + 1) / threadCount));
+
+            std::mutex errorMutex;
+            std::exception_ptr error;
+            auto worker = [&](std::size_t self) {
+                try {
+                    for (std::size_t victim = self; victim < self + threadCount; victim++) {
+                        auto &range = ranges[victim % threadCount];
+                        while (auto index = victim == self ? range.pop_front() : range.steal_back()) {
+                            const auto &resource = *selected[*index];
+                            impl::ROMFS_CONCAT(pin_, LIBROMFS_PROJECT_NAME)(resource, false);
+                            impl::ROMFS_CONCAT(unpin_, LIBROMFS_PROJECT_NAME)(resource);
+                        }
+                    }
+                } catch (...) {
+                    std::scoped_lock lock(errorMutex);
+                    if (error == nullptr)
+                        error = std::current_exception();
+                }
+            };
+
+            // The calling thread is one of the workers. When no more threads can be started, the ones that are
+            // running steal the shares of the missing workers
+            std::vector<std::thread> threads;
+            threads.reserve(threadCount - 1);
+            for (std::size_t i = 1; i < threadCount; i++) {
+                try {
+                    threads.emplace_back(worker, i);
+                } catch (const std::system_error &) {
+                    break;
+                }
+            }
+            worker(0);
+
+            for (auto &thread : threads)
+                thread.join();
+
+            if (error != nullptr)
+                std::rethrow_exception(error);
+        }
+
+    }
+
+    ROMFS_VISIBILITY void impl::ROMFS_CONCAT(preload_, LIBROMFS_PROJECT_NAME)(const std::function<bool(std::string_view)> &predicate, std::size_t threadCount) {
+        preload_resources(predicate, threadCount);
+    }
+
+    ROMFS_VISIBILITY void impl::ROMFS_CONCAT(preload_, LIBROMFS_PROJECT_NAME)(std::string_view pattern, std::size_t threadCount) {
+        preload_resources([pattern](std::string_view path) { return match_glob(pattern, path); }, threadCount);
+    }
+
+    namespace {
+
+        // Default executor of get_async(), its threads are only started once the first job comes in
+        class ThreadPool {
+        public:
+            ~ThreadPool() {
+                {
+                    std::scoped_lock lock(this->m_mutex);
+                    this->m_stopping = true;
+                }
+                this->m_condition.notify_all();
+
+                for (auto &thread : this->m_threads)
+                    thread.join();
+            }
+
+            void submit(std::function<void()> job) {
+                {
+                    std::scoped_lock lock(this->m_mutex);
+                    if (this->m_threads.empty()) {
+                        for (std::size_t i = 0; i < std::max(1U, std::thread::hardware_concurrency()); i++)
+                            this->m_threads.emplace_back([this] { this->work(); });
+                    }
+
+                    this->m_jobs.push_back(std::move(job));
+                }
+                this->m_condition.notify_one();
+            }
+
+        private:
+            void work() {
+                while (true) {
+                    std::function<void()> job;
+                    {
+                        std::unique_lock lock(this->m_mutex);
+                        this->m_condition.wait(lock, [this] { return this->m_stopping || !this->m_jobs.empty(); });
+                        if (this->m_jobs.empty())
+                            return;
+
+                        job = std::move(this->m_jobs.front());
+                        this->m_jobs.pop_front();
+                    }
+
+                    job();
+                }
+            }
+
+            std::mutex m_mutex;
+            std::condition_variable m_condition;
+            std::deque<std::function<void()>> m_jobs;
+            std::vector<std::thread> m_threads;
+            bool m_stopping = false;
+        };
+
+        struct AsyncContext {
+            std::mutex mutex;
+            std::function<void(std::function<void()>)> executor;
+            std::map<const impl::ResourceState*, std::shared_ptr<impl::AsyncOperation>> operations;
+            ThreadPool pool;
+        };
+
+        AsyncContext& get_async_context() {
+            static AsyncContext context;
+            return context;
+        }
+
+        void complete_operation(impl::AsyncOperation &operation, std::exception_ptr error) {
+            std::vector<std::function<void()>> continuations;
+            {
+                std::scoped_lock lock(operation.mutex);
+                operation.done = true;
+                operation.error = std::move(error);
+                continuations.swap(operation.continuations);
+            }
+            operation.condition.notify_all();
+
+            for (auto &continuation : continuations)
+                continuation();
+        }
+
+    }
+
+    ROMFS_VISIBILITY std::shared_ptr<impl::AsyncOperation> impl::ROMFS_CONCAT(get_async_, LIBROMFS_PROJECT_NAME)(const Resource &resource) {
+        if (!resource.compressed())
+            return nullptr;
+
+        // Data that is decompressed for good can't be evicted before the caller gets to pin it
+        auto &state = ResourceAccess::state(resource);
+        if (state.status.load(std::memory_order_acquire) & ResourceState::PinnedForever)
+            return nullptr;
+
+        auto &context = get_async_context();
+        std::unique_lock lock(context.mutex);
+
+        // Somebody else already asked for this resource, wait for the same decompression
+        auto [it, inserted] = context.operations.try_emplace(&state);
+        if (!inserted)
+            return it->second;
+
+        auto operation = std::make_shared<AsyncOperation>();
+        it->second = operation;
+
+        auto job = [resource, operation] {
+            auto &context = get_async_context();
+
+            // Keep the data pinned until every awaiter got resumed and pinned it themselves
+            Pin pin;
+            std::exception_ptr error;
+            try {
+                pin = resource.pin();
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            {
+                std::scoped_lock lock(context.mutex);
+                context.operations.erase(&ResourceAccess::state(resource));
+            }
+
+            complete_operation(*operation, std::move(error));
+        };
+
+        auto executor = context.executor;
+        lock.unlock();
+
+        // Nothing would ever complete the operation if it couldn't be dispatched, so fail everybody waiting for it instead
+        try {
+            if (executor)
+                executor(std::move(job));
+            else
+                context.pool.submit(std::move(job));
+        } catch (...) {
+            {
+                std::scoped_lock failedLock(context.mutex);
+                if (auto failed = context.operations.find(&state); failed != context.operations.end() && failed->second == operation)
+                    context.operations.erase(failed);
+            }
+
+            complete_operation(*operation, std::current_exception());
+            throw;
+        }
+
+        return operation;
+    }
+
+    ROMFS_VISIBILITY void impl::ROMFS_CONCAT(set_executor_, LIBROMFS_PROJECT_NAME)(std::function<void(std::function<void()>)> executor) {
+        auto &context = get_async_context();
+        std::scoped_lock lock(context.mutex);
+
+        context.executor = std::move(executor);
+    }
+
+    ROMFS_VISIBILITY void impl::ROMFS_CONCAT(read_, LIBROMFS_PROJECT_NAME)(const Resource &resource, std::size_t offset, std::size_t length, std::byte *dst) {
+        if (auto block = ResourceAccess::block(resource); block != nullptr)
+            return ROMFS_CONCAT(read_, LIBROMFS_PROJECT_NAME)(*block, ResourceAccess::offset(resource) + offset, length, dst);
+
+        // Data that is decompressed already doesn't need to be decompressed again, as long as it can't get evicted meanwhile.
+        // Reading doesn't add anything to the cache, so dropping the pin again doesn't trim it either
+        auto &state = ResourceAccess::state(resource);
+        if (auto data = try_pin(resource, state.status.load(std::memory_order_acquire), false); data != nullptr) {
+            std::memcpy(dst, data + offset, length);
+            state.status.fetch_sub(ResourceState::OnePin, std::memory_order_release);
+            return;
+        }
+
+        // Partially read chunks get decompressed into this buffer first, it only ever grows to the chunk size
+        thread_local std::vector<std::byte> buffer;
+
+        const auto size = resource.size();
+        const auto chunkSize = chunk_size(resource);
+        const auto end = offset + length;
+
+        for (auto index = offset / chunkSize; offset < end; index++) {
+            const auto chunkBegin = index * chunkSize;
+            const auto chunkLength = std::min(chunkSize, size - chunkBegin);
+            const auto copyLength = std::min(end, chunkBegin + chunkLength) - offset;
+
+            if (offset == chunkBegin && copyLength == chunkLength) {
+                // Chunks that are read entirely are decompressed straight into the destination
+                decompress(dst, chunkLength, compressed_chunk(resource, index));
+            } else {
+                buffer.resize(chunkLength);
+                decompress(buffer.data(), chunkLength, compressed_chunk(resource, index));
+                std::memcpy(dst, buffer.data() + (offset - chunkBegin), copyLength);
+            }
+
+            dst += copyLength;
+            offset += copyLength;
+        }
+    }
+
+
+    ROMFS_VISIBILITY const romfs::Resource &impl::ROMFS_CONCAT(get_, LIBROMFS_PROJECT_NAME)(const fs::path &path) {
+        if (auto resource = find_resource(path.generic_string()); resource != nullptr)
+            return *resource;
+
+        throw std::invalid_argument(std::string("Invalid romfs resource path for '") + std::string(romfs::name()) + "' : " + path.string());
+    }
+
+    ROMFS_VISIBILITY const romfs::Resource &impl::ROMFS_CONCAT(get_, LIBROMFS_PROJECT_NAME)(std::string_view path) {
+        if (auto resource = find_resource(path); resource != nullptr)
+            return *resource;
+
+        throw std::invalid_argument(std::string("Invalid romfs resource path for '") + std::string(romfs::name()) + "' : " + std::string(path));
+    }
+
+    ROMFS_VISIBILITY const romfs::Resource *impl::ROMFS_CONCAT(find_, LIBROMFS_PROJECT_NAME)(std::string_view path) noexcept {
+        return find_resource(path);
+    }
+
+    ROMFS_VISIBILITY std::vector<fs::path> impl::ROMFS_CONCAT(list_, LIBROMFS_PROJECT_NAME)(const fs::path &parent) {
+        auto paths = list_directory(parent.generic_string());
+        return { paths.begin(), paths.end() };
+    }
+
+    ROMFS_VISIBILITY nonstd::span<const std::string_view> impl::ROMFS_CONCAT(list_, LIBROMFS_PROJECT_NAME)(std::string_view parent) noexcept {
+        return list_directory(parent);
+    }
+
+    ROMFS_VISIBILITY EntryRange impl::ROMFS_CONCAT(entries_, LIBROMFS_PROJECT_NAME)(std::string_view path, bool recursive) noexcept {
+        auto directory = find_directory(path);
+        if (directory == nullptr)
+            return {};
+
+        auto directories = ROMFS_CONCAT(ROMFS_NAME, _get_directories)();
+        return EntryRange(impl::EntryIterator(ROMFS_CONCAT(ROMFS_NAME, _get_resources)().data(), directories.data(), directory - directories.data(), recursive));
+    }
+
+    ROMFS_VISIBILITY Reader impl::ROMFS_CONCAT(open_, LIBROMFS_PROJECT_NAME)(const Resource &resource) {
+        // Resources that are stored uncompressed or are decompressed for good are simply copied from
+        #if defined(LIBROMFS_COMPRESS_RESOURCES)
+            if (resource.compressed() && !(ResourceAccess::state(resource).status.load(std::memory_order_acquire) & ResourceState::PinnedForever)) {
+                auto block = ResourceAccess::block(resource);
+                if (block == nullptr)
+                    return { resource, std::make_unique<StreamReaderState>(resource) };
+
+                // Solid blocks are small, so decompressing and dropping everything in front of the resource is cheap
+                auto state = std::make_unique<StreamReaderState>(*block);
+                std::array<std::byte, 4096> skipped;
+                for (auto remaining = ResourceAccess::offset(resource); remaining > 0;) {
+                    const auto length = std::min(remaining, skipped.size());
+                    state->read({ skipped.data(), length });
+                    remaining -= length;
+                }
+
+                return { resource, std::move(state) };
+            }
+        #endif
+
+        return { resource, nullptr };
+    }
+
     ROMFS_VISIBILITY std::string_view impl::ROMFS_CONCAT(name_, LIBROMFS_PROJECT_NAME)() {
         return ROMFS_CONCAT(ROMFS_NAME, _get_name)();
     }
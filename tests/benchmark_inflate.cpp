@@ -0,0 +1,114 @@
+// Compares zlib's inflate() against libdeflate when decompressing the test resources the way libromfs does:
+// every resource compressed at Z_BEST_COMPRESSION and decompressed whole into a buffer of its known size.
+// Not part of the test suite, run libromfs-benchmark-inflate [iterations] manually
+
+#include <zlib.h>
+#if defined(LIBROMFS_BENCHMARK_LIBDEFLATE)
+    #include <libdeflate.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct Sample {
+        std::vector<unsigned char> data;
+        std::vector<unsigned char> compressed;
+    };
+
+    std::vector<Sample> load_corpus(const std::filesystem::path &root) {
+        std::vector<Sample> samples;
+        for (const auto &entry : std::filesystem::recursive_directory_iterator(root)) {
+            if (!entry.is_regular_file() || entry.file_size() == 0)
+                continue;
+
+            std::ifstream file(entry.path(), std::ios::binary);
+            Sample sample;
+            sample.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+            auto compressedSize = compressBound(sample.data.size());
+            sample.compressed.resize(compressedSize);
+            if (compress2(sample.compressed.data(), &compressedSize, sample.data.data(), sample.data.size(), Z_BEST_COMPRESSION) != Z_OK) {
+                std::fprintf(stderr, "Failed to compress %s\n", entry.path().string().c_str());
+                std::exit(EXIT_FAILURE);
+            }
+            sample.compressed.resize(compressedSize);
+
+            samples.push_back(std::move(sample));
+        }
+
+        return samples;
+    }
+
+    bool inflate_zlib(const Sample &sample, unsigned char *output) {
+        z_stream stream = {};
+        stream.avail_in = sample.compressed.size();
+        stream.next_in = const_cast<unsigned char*>(sample.compressed.data());
+        if (inflateInit(&stream) != Z_OK)
+            return false;
+
+        stream.avail_out = sample.data.size();
+        stream.next_out = output;
+
+        auto ret = inflate(&stream, Z_FINISH);
+        inflateEnd(&stream);
+
+        return ret == Z_STREAM_END && stream.total_out == sample.data.size();
+    }
+
+    void run(const char *name, const std::vector<Sample> &samples, std::size_t iterations, const std::function<bool(const Sample&, unsigned char*)> &decompress) {
+        std::vector<unsigned char> output;
+        std::size_t totalBytes = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; i++) {
+            for (const auto &sample : samples) {
+                output.resize(sample.data.size());
+                if (!decompress(sample, output.data()) || output != sample.data) {
+                    std::fprintf(stderr, "%s produced wrong output\n", name);
+                    std::exit(EXIT_FAILURE);
+                }
+
+                totalBytes += sample.data.size();
+            }
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::printf("%-28s %10.2f MB/s\n", name, double(totalBytes) / elapsed.count() / (1024 * 1024));
+    }
+
+}
+
+int main(int argc, char **argv) {
+    const std::size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+
+    auto samples = load_corpus(LIBROMFS_BENCHMARK_CORPUS);
+    std::printf("Decompressing %zu resources %zu times\n", samples.size(), iterations);
+
+    run("zlib inflate()", samples, iterations, inflate_zlib);
+
+    #if defined(LIBROMFS_BENCHMARK_LIBDEFLATE)
+        auto decompressor = libdeflate_alloc_decompressor();
+
+        run("libdeflate", samples, iterations, [&](const Sample &sample, unsigned char *output) {
+            return libdeflate_zlib_decompress(decompressor, sample.compressed.data(), sample.compressed.size(), output, sample.data.size(), nullptr) == LIBDEFLATE_SUCCESS;
+        });
+        run("libdeflate without checksum", samples, iterations, [&](const Sample &sample, unsigned char *output) {
+            return libdeflate_deflate_decompress(decompressor, sample.compressed.data() + 2, sample.compressed.size() - 6, output, sample.data.size(), nullptr) == LIBDEFLATE_SUCCESS;
+        });
+
+        libdeflate_free_decompressor(decompressor);
+    #else
+        std::printf("libdeflate is unavailable, only zlib has been measured\n");
+    #endif
+
+    return EXIT_SUCCESS;
+}
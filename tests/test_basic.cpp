@@ -1,8 +1,15 @@
 #include "test_framework.hpp"
 #include <romfs/romfs.hpp>
 #include <iostream>
+#include <cstdint>
 #include <cstring>
 #include <cassert>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <ranges>
+#include <tuple>
+#include <vector>
 
 using namespace test;
 
@@ -10,7 +17,7 @@ using namespace test;
 TEST(project_name) {
     auto name = romfs::name();
     ASSERT(!name.empty(), "Project name should not be empty");
-    ASSERT_STR_EQ(name, "test_project", "Project name should be 'test_project'");
+    ASSERT_STR_EQ(name, LIBROMFS_TEST_PROJECT_NAME, "Project name should be '" LIBROMFS_TEST_PROJECT_NAME "'");
 }
 
 // Test: Get existing file
@@ -44,11 +51,83 @@ TEST(get_file_data_pointer) {
     ASSERT(static_cast<char>(data[1]) == 'e', "Second byte should be 'e'");
 }
 
+// Test: Read a range of a file
+TEST(read_file_range) {
+    auto resource = romfs::get("hello.txt");
+
+    char buffer[32] = {};
+    ASSERT_EQ(resource.read(7, sizeof(buffer), reinterpret_cast<std::byte*>(buffer)), 9, "Read should stop at the end of the file");
+    ASSERT_STR_EQ(std::string_view(buffer, 9), "libromfs!", "Read content should match");
+    ASSERT_EQ(resource.read(16, sizeof(buffer), reinterpret_cast<std::byte*>(buffer)), 0, "Reading past the end should copy nothing");
+}
+
+// Test: Copy a file into a caller buffer
+TEST(decompress_into_buffer) {
+    const auto& resource = romfs::get("hello.txt");
+    ASSERT_EQ(resource.uncompressed_size(), 16, "Uncompressed size should match the file size");
+
+    std::vector<std::byte> buffer(resource.uncompressed_size());
+    ASSERT_EQ(resource.decompress_into(buffer), 16, "The whole file should have been copied");
+    ASSERT_STR_EQ(std::string_view(reinterpret_cast<const char*>(buffer.data()), buffer.size()), "Hello, libromfs!", "Content should match");
+
+    bool threw = false;
+    try {
+        std::byte small[4];
+        resource.decompress_into(small);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ASSERT(threw, "Decompressing into a buffer that is too small should throw std::invalid_argument");
+}
+
+// Test: Stored files have nothing to release
+TEST(release_stored_file) {
+    const auto& resource = romfs::get("binary.bin");
+    ASSERT(!resource.release(), "Stored files have no decompressed data");
+    ASSERT(resource.string().starts_with("\x89PNG"), "Stored content should stay available");
+}
+
+// Test: Stream a file in pieces
+TEST(open_file_stream) {
+    auto reader = romfs::open("hello.txt");
+
+    std::string content;
+    std::byte buffer[5];
+    while (auto bytesRead = reader.read(buffer))
+        content.append(reinterpret_cast<const char*>(buffer), bytesRead);
+
+    ASSERT_STR_EQ(content, "Hello, libromfs!", "Streamed content should match");
+    ASSERT_EQ(reader.position(), 16, "Reader should have advanced to the end");
+    ASSERT(reader.eof(), "Reader should be at the end");
+}
+
+// Test: Opening a non-existent file throws exception
+TEST(open_nonexistent_file_throws) {
+    bool threw = false;
+    try {
+        auto reader = romfs::open("does_not_exist.txt");
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ASSERT(threw, "Opening non-existent file should throw std::invalid_argument");
+}
+
+// Test: Preloading asks the predicate about every file
+TEST(preload_predicate) {
+    std::size_t calls = 0;
+    romfs::preload([&](std::string_view) { calls++; return false; }, 4);
+    ASSERT_EQ(calls, romfs::list().size(), "Predicate should be called for every file");
+
+    romfs::preload("**/*.json");
+    romfs::preload("does/not/*/exist", 1);
+    ASSERT_STR_EQ(romfs::get("hello.txt").string(), "Hello, libromfs!", "Content should be intact after preloading");
+}
+
 // Test: Get non-existent file throws exception
 TEST(get_nonexistent_file_throws) {
     bool threw = false;
     try {
-        auto resource = romfs::get("does_not_exist.txt");
+        std::ignore = romfs::get("does_not_exist.txt");
     } catch (const std::invalid_argument&) {
         threw = true;
     }
@@ -93,6 +172,93 @@ TEST(list_subdirectory) {
     ASSERT(found_nested, "Should find nested.txt in subdir");
 }
 
+// Test: string_view lookups resolve the same resources as fs::path lookups
+TEST(get_string_view) {
+    std::string_view path = "subdir/nested.txt";
+    ASSERT(&romfs::get(path) == &romfs::get(fs::path(path)), "string_view and fs::path lookups should match");
+    ASSERT(romfs::find(path) == &romfs::get(path), "find() should return the same resource as get()");
+    ASSERT(romfs::find(std::string_view("subdir/missing.txt")) == nullptr, "find() should return nullptr for missing resources");
+}
+
+// Test: Probing for resources never throws
+TEST(exists_and_find_do_not_throw) {
+    static_assert(noexcept(romfs::find("hello.txt")), "find() should be noexcept");
+    static_assert(noexcept(romfs::exists("hello.txt")), "exists() should be noexcept");
+
+    ASSERT(romfs::exists("hello.txt"), "hello.txt should exist");
+    ASSERT(romfs::exists("subdir/nested.txt"), "subdir/nested.txt should exist");
+    ASSERT(!romfs::exists("script.py"), "Excluded files should not exist");
+    ASSERT(!romfs::exists("subdir"), "Directories are not resources");
+    ASSERT(romfs::find("does_not_exist.txt") == nullptr, "find() should return nullptr for missing resources");
+}
+
+// Test: string_view listing of a subdirectory
+TEST(list_string_view) {
+    auto files = romfs::list(std::string_view("subdir/"));
+    ASSERT_EQ(files.size(), 1, "subdir should contain exactly one file");
+    ASSERT_STR_EQ(files[0], "subdir/nested.txt", "Listed path should be the generated path");
+    ASSERT_EQ(romfs::list(std::string_view()).size(), romfs::list().size(), "Empty path should list every file");
+}
+
+// Test: Listing returns only the direct files of a directory
+TEST(list_directory_children) {
+    for (const auto& file : romfs::list(std::string_view(""))) {
+        ASSERT(romfs::exists(file), "Every listed path should exist");
+    }
+
+    ASSERT_EQ(romfs::list("subdir/nested.txt").size(), 0, "Files have no children");
+    ASSERT_EQ(romfs::list(std::string_view("missing_folder")).size(), 0, "Missing directories have no children");
+}
+
+// Test: entries() yields direct files and subdirectories
+TEST(entries_root) {
+    static_assert(std::ranges::forward_range<romfs::EntryRange>, "EntryRange should be a forward range");
+    static_assert(std::ranges::view<romfs::EntryRange>, "EntryRange should be a view");
+
+    std::size_t files = 0, directories = 0;
+    for (auto entry : romfs::entries()) {
+        if (entry.is_directory()) {
+            ASSERT_STR_EQ(entry.path(), "subdir", "Only subdir should be listed as a directory");
+            directories++;
+        } else {
+            ASSERT(&entry.resource() == &romfs::get(entry.path()), "Entry should reference the resource at its path");
+            files++;
+        }
+    }
+
+    ASSERT_EQ(directories, 1, "Root should contain one directory");
+    auto nested = std::ranges::count_if(romfs::walk("subdir"), [](const romfs::Entry& entry) { return !entry.is_directory(); });
+    ASSERT_EQ(files, romfs::list().size() - std::size_t(nested), "Root should contain every file outside of subdir");
+}
+
+// Test: walk() recursively yields every file and directory
+TEST(walk_recursive) {
+    auto files = std::ranges::count_if(romfs::walk(), [](const romfs::Entry& entry) { return !entry.is_directory(); });
+    ASSERT_EQ(std::size_t(files), romfs::list().size(), "walk() should visit every file");
+
+    auto nested = romfs::walk("subdir");
+    ASSERT(!nested.empty(), "subdir should not be empty");
+    ASSERT_STR_EQ(nested.front().path(), "subdir/nested.txt", "walk() should yield the nested file");
+    ASSERT(romfs::walk("missing_folder").empty(), "Missing directories should yield nothing");
+}
+
+// Test: Every embedded resource matches the file it was generated from, wherever its data ended up
+TEST(resources_match_source_files) {
+    for (auto entry : romfs::walk()) {
+        if (entry.is_directory())
+            continue;
+
+        std::ifstream file(std::string(LIBROMFS_TEST_RESOURCE_LOCATION) + "/" + std::string(entry.path()), std::ios::binary);
+        ASSERT(file.is_open(), "Source file should be readable");
+        std::string expected(std::istreambuf_iterator<char>(file), {});
+
+        const auto& resource = entry.resource();
+        std::string content(resource.size(), '\0');
+        resource.read(0, content.size(), reinterpret_cast<std::byte*>(content.data()));
+        ASSERT(content == expected, "Resource content should match its source file");
+    }
+}
+
 // Test: Get nested file
 TEST(get_nested_file) {
     auto resource = romfs::get("subdir/nested.txt");
@@ -101,6 +267,25 @@ TEST(get_nested_file) {
     ASSERT(content.find("subdirectory") != std::string::npos, "Content should mention 'subdirectory'");
 }
 
+// Test: Redundant separators and "." components resolve to the same resource
+TEST(get_normalized_path) {
+    auto& resource = romfs::get("subdir//nested.txt");
+    auto& dotted = romfs::get("./subdir/./nested.txt");
+    ASSERT(&resource == &romfs::get("subdir/nested.txt"), "Redundant separators should be ignored");
+    ASSERT(&dotted == &resource, "'.' components should be ignored");
+}
+
+// Test: Paths that only share a hash slot with an existing resource are rejected
+TEST(get_similar_path_throws) {
+    bool threw = false;
+    try {
+        std::ignore = romfs::get("subdir/nested.tx");
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ASSERT(threw, "Prefix of an existing path should not resolve");
+}
+
 // Test: Binary file integrity
 TEST(binary_file_integrity) {
     auto resource = romfs::get("binary.bin");
@@ -128,7 +313,7 @@ TEST(json_file_content) {
 TEST(romfsignore_excludes_python) {
     bool threw = false;
     try {
-        auto resource = romfs::get("script.py");
+        std::ignore = romfs::get("script.py");
     } catch (const std::invalid_argument&) {
         threw = true;
     }
@@ -139,7 +324,7 @@ TEST(romfsignore_excludes_python) {
 TEST(romfsignore_excludes_temp) {
     bool threw = false;
     try {
-        auto resource = romfs::get("tempfile.tmp");
+        std::ignore = romfs::get("tempfile.tmp");
     } catch (const std::invalid_argument&) {
         threw = true;
     }
@@ -150,7 +335,7 @@ TEST(romfsignore_excludes_temp) {
 TEST(romfsignore_excludes_markdown) {
     bool threw = false;
     try {
-        auto resource = romfs::get("test.md");
+        std::ignore = romfs::get("test.md");
     } catch (const std::invalid_argument&) {
         threw = true;
     }
@@ -161,7 +346,7 @@ TEST(romfsignore_excludes_markdown) {
 TEST(romfsignore_excludes_folders) {
     bool threw = false;
     try {
-        auto resource = romfs::get("ignored_folder/ignored.txt");
+        std::ignore = romfs::get("ignored_folder/ignored.txt");
     } catch (const std::invalid_argument&) {
         threw = true;
     }
@@ -177,13 +362,31 @@ TEST(romfsignore_includes_allowed_files) {
            "included.txt should have correct content");
 }
 
+// Test: .romfscompress - Verify .romfscompress itself is excluded
+TEST(romfscompress_file_excluded) {
+    ASSERT(!romfs::exists(".romfscompress"), ".romfscompress file itself should be excluded");
+}
+
 // Test: .romfsignore - Verify .romfsignore itself is excluded
 TEST(romfsignore_file_excluded) {
     bool threw = false;
     try {
-        auto resource = romfs::get(".romfsignore");
+        std::ignore = romfs::get(".romfsignore");
     } catch (const std::invalid_argument&) {
         threw = true;
     }
     ASSERT(threw, ".romfsignore file itself should be excluded");
 }
+
+// Test: Resources stored in a blob start at a multiple of the configured alignment
+TEST(blob_alignment) {
+#if LIBROMFS_TEST_BLOB_ALIGNMENT > 0
+    for (auto entry : romfs::walk()) {
+        if (entry.is_directory() || entry.resource().compressed())
+            continue;
+
+        auto address = reinterpret_cast<std::uintptr_t>(entry.resource().data());
+        ASSERT_EQ(address % LIBROMFS_TEST_BLOB_ALIGNMENT, 0, "Stored resources should be aligned inside of the blob");
+    }
+#endif
+}
@@ -1,7 +1,18 @@
 #include "test_framework.hpp"
 #include <romfs/romfs.hpp>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory_resource>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
 #include <vector>
 
 using namespace test;
@@ -9,6 +20,11 @@ using namespace test;
 // Only run compression tests if compression is enabled
 #ifdef LIBROMFS_COMPRESS_RESOURCES
 
+#if LIBROMFS_COMPRESSION_CODEC == 2
+// Generated alongside the resources, the dictionary all of them have been compressed against
+nonstd::span<const std::uint8_t> ROMFS_CONCAT(ROMFS_NAME, _get_dictionary)();
+#endif
+
 // Test: Compressed file still returns correct size
 TEST(compressed_file_size) {
     auto resource = romfs::get("hello.txt");
@@ -54,6 +70,301 @@ TEST(compressed_file_caching) {
     ASSERT(data1 == data2, "Data pointer should be identical (cached)");
 }
 
+// Test: Unpinned data gets evicted once over budget and is decompressed again on its next use
+TEST(cache_budget_eviction) {
+    const auto& resource = romfs::get("lorem.txt");
+
+    // Lowering the budget already evicts whatever else earlier tests left unpinned
+    romfs::set_cache_budget(1);
+    const auto usedBefore = romfs::cache_usage().used;
+    {
+        auto pin = resource.pin();
+        ASSERT(pin, "Pin should be valid");
+        ASSERT_EQ(pin.size(), resource.size(), "Pin should cover the whole resource");
+        ASSERT(romfs::cache_usage().pinned > resource.size(), "Pinned data should be accounted for");
+        ASSERT(romfs::cache_usage().used > usedBefore, "Pinned data must not be evicted, even when over budget");
+    }
+    ASSERT_EQ(romfs::cache_usage().used, usedBefore, "Unpinned data should have been evicted");
+
+    auto pin = resource.pin();
+    std::string expected(resource.size(), '\0');
+    resource.read(0, expected.size(), reinterpret_cast<std::byte*>(expected.data()));
+    ASSERT(pin.string() == expected, "Data should be intact after being evicted");
+
+    pin.reset();
+    romfs::set_cache_budget(0);
+    ASSERT_EQ(romfs::cache_usage().budget, 0, "Budget should have been reset");
+}
+
+// Test: Pinning and evicting the same resource from many threads at once
+TEST(concurrent_pin_eviction) {
+    const auto& resource = romfs::get("lorem.txt");
+    std::string expected(resource.size(), '\0');
+    resource.read(0, expected.size(), reinterpret_cast<std::byte*>(expected.data()));
+
+    romfs::set_cache_budget(1);
+
+    std::atomic<bool> intact = true;
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+            for (std::size_t iteration = 0; iteration < 200; iteration++) {
+                auto pin = resource.pin();
+                if (pin.string() != expected)
+                    intact = false;
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    romfs::set_cache_budget(0);
+    ASSERT(intact, "Every pin should see intact data");
+}
+
+// Test: Preloaded resources are decompressed once preload() returns
+TEST(preload_compressed) {
+    const auto usedBefore = romfs::cache_usage().used;
+    romfs::preload("lorem.*", 2);
+    ASSERT_EQ(romfs::cache_usage().used, usedBefore + romfs::get("lorem.txt").size() + 1, "lorem.txt should have been decompressed");
+
+    romfs::set_cache_budget(1);
+    romfs::set_cache_budget(0);
+    ASSERT_EQ(romfs::cache_usage().used, usedBefore, "Preloaded data isn't pinned");
+}
+
+// Test: Decompressing into a caller buffer leaves nothing behind in the cache
+TEST(compressed_decompress_into) {
+    const auto& resource = romfs::get("lorem.txt");
+    const auto usedBefore = romfs::cache_usage().used;
+
+    std::vector<std::byte> buffer(resource.uncompressed_size());
+    ASSERT_EQ(resource.decompress_into(buffer), resource.size(), "The whole resource should have been decompressed");
+    ASSERT_EQ(romfs::cache_usage().used, usedBefore, "No decompressed copy should have been kept");
+
+    // Checked against what lorem.txt is known to contain rather than another decompression of it
+    std::string_view content(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    ASSERT_EQ(content.size(), 2158, "lorem.txt should be decompressed to its original size");
+    ASSERT(content.starts_with("Reprehenderit ut nulla adipiscing do laborum"), "Decompressed content should start like lorem.txt");
+    ASSERT(content.ends_with("magna sint. (26)\n"), "Decompressed content should end like lorem.txt");
+
+    // Every line of lorem.txt is numbered, so chunks decompressed out of order or twice would show up here
+    std::size_t line = 0;
+    for (std::size_t begin = 0; begin < content.size(); line++) {
+        auto end = content.find('\n', begin);
+        auto text = content.substr(begin, end - begin);
+        ASSERT(text.ends_with("(" + std::to_string(line) + ")"), "Lines should be decompressed in order");
+        begin = end + 1;
+    }
+    ASSERT_EQ(line, 27, "lorem.txt has 27 lines");
+}
+
+// Test: Streaming a compressed resource through a small buffer yields the same bytes as reading it at once
+TEST(compressed_streaming_read) {
+    const auto& resource = romfs::get("lorem.txt");
+
+    std::string expected(resource.size(), '\0');
+    resource.read(0, expected.size(), reinterpret_cast<std::byte*>(expected.data()));
+
+    auto reader = romfs::open(resource);
+    ASSERT_EQ(reader.size(), resource.size(), "Reader should cover the whole resource");
+
+    // An odd buffer size so reads straddle chunk boundaries
+    std::string streamed;
+    std::byte buffer[37];
+    while (auto bytesRead = reader.read(buffer))
+        streamed.append(reinterpret_cast<const char*>(buffer), bytesRead);
+
+    ASSERT(reader.eof(), "Reader should be at the end");
+    ASSERT(streamed == expected, "Streamed content should match");
+}
+
+// Test: A reader keeps working after the resource it was opened from went out of scope
+TEST(reader_outlives_resource) {
+    auto reader = [] {
+        auto copy = romfs::get("lorem.txt");
+        return romfs::open(copy);
+    }();
+
+    std::string streamed;
+    std::byte buffer[37];
+    while (auto bytesRead = reader.read(buffer))
+        streamed.append(reinterpret_cast<const char*>(buffer), bytesRead);
+
+    const auto& resource = romfs::get("lorem.txt");
+    std::string expected(resource.size(), '\0');
+    resource.read(0, expected.size(), reinterpret_cast<std::byte*>(expected.data()));
+    ASSERT(streamed == expected, "Streamed content should match");
+}
+
+// Test: Range reads only decompress the chunks they touch and match the fully decompressed data
+TEST(chunked_range_read) {
+    const auto& resource = romfs::get("lorem.txt");
+    ASSERT(resource.compressed(), "lorem.txt should be compressed as configured in .romfscompress");
+
+    // Read before anything decompressed the whole resource, across chunk boundaries and whole chunks
+    const std::pair<std::size_t, std::size_t> ranges[] = { { 0, 10 }, { 250, 20 }, { 256, 512 }, { 100, 1000 }, { 0, resource.size() }, { resource.size() - 5, 100 } };
+    std::vector<std::string> reads;
+    for (auto [offset, length] : ranges) {
+        std::string buffer(length, '\0');
+        buffer.resize(resource.read(offset, length, reinterpret_cast<std::byte*>(buffer.data())));
+        reads.push_back(buffer);
+    }
+
+    auto pin = resource.pin();
+    auto content = pin.string();
+    for (std::size_t i = 0; i < reads.size(); i++) {
+        auto [offset, length] = ranges[i];
+        ASSERT(reads[i] == content.substr(offset, length), "Range read should match the decompressed data");
+    }
+
+    std::byte byte;
+    ASSERT_EQ(resource.read(resource.size(), 1, &byte), 0, "Reading past the end should copy nothing");
+}
+
+// Test: Empty resources decompress to nothing
+TEST(compressed_empty_resource) {
+    const auto& resource = romfs::get("empty.txt");
+    ASSERT(resource.compressed(), "empty.txt should be compressed as configured in .romfscompress");
+    ASSERT_EQ(resource.size(), 0, "Empty resource should have no size");
+    ASSERT(resource.string().empty(), "Empty resource should have no content");
+}
+
+// Test: Concurrent asynchronous requests for the same resource share one decompression
+TEST(async_shared_decompression) {
+    std::vector<std::function<void()>> jobs;
+    romfs::set_executor([&](std::function<void()> job) { jobs.push_back(std::move(job)); });
+
+    auto first = romfs::get_async("lorem.txt");
+    auto second = romfs::get_async("lorem.txt");
+    ASSERT_EQ(jobs.size(), 1, "Both requests should share one job");
+    ASSERT(!first.ready() && !second.ready(), "Nothing should be ready before the job ran");
+
+    for (auto& job : jobs)
+        job();
+    romfs::set_executor({});
+
+    ASSERT(first.ready() && second.ready(), "Both requests should be ready once the job ran");
+    ASSERT(first.get().string() == second.get().string(), "Both requests should see the same data");
+    ASSERT_EQ(first.get().size(), romfs::get("lorem.txt").size(), "Data should cover the whole resource");
+}
+
+// Test: A request that couldn't be dispatched fails without leaving anything behind for later requests to wait on
+TEST(async_dispatch_failure) {
+    romfs::set_executor([](std::function<void()>) { throw std::runtime_error("Executor is unavailable"); });
+
+    bool threw = false;
+    try {
+        std::ignore = romfs::get_async("lorem.txt");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "Dispatch errors should reach the caller");
+
+    std::vector<std::function<void()>> jobs;
+    romfs::set_executor([&](std::function<void()> job) { jobs.push_back(std::move(job)); });
+
+    auto pending = romfs::get_async("lorem.txt");
+    ASSERT_EQ(jobs.size(), 1, "The next request should be dispatched again");
+
+    for (auto& job : jobs)
+        job();
+    romfs::set_executor({});
+
+    ASSERT(pending.ready(), "The next request should complete");
+    ASSERT_EQ(pending.get().size(), romfs::get("lorem.txt").size(), "Data should cover the whole resource");
+}
+
+// Test: Decompressed data comes from the memory resource set by the user
+TEST(custom_memory_resource) {
+    struct CountingResource : std::pmr::memory_resource {
+        std::size_t allocations = 0, deallocations = 0;
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            allocations++;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override {
+            deallocations++;
+            std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    } counting;
+
+    const auto& resource = romfs::get("lorem.txt");
+
+    // Evict whatever has been decompressed before so the next pin allocates again
+    romfs::set_cache_budget(1);
+    romfs::set_memory_resource(&counting);
+    {
+        auto pin = resource.pin();
+        ASSERT_EQ(counting.allocations, 1, "Decompressing should allocate from the memory resource");
+    }
+    ASSERT_EQ(counting.deallocations, 1, "Evicting should give the data back to the memory resource");
+
+    romfs::set_memory_resource(nullptr);
+    romfs::set_cache_budget(0);
+}
+
+// Test: The arena places every resource at the same address, no matter how often it gets evicted
+TEST(arena_allocation) {
+    const auto& resource = romfs::get("lorem.txt");
+    std::string expected(resource.size(), '\0');
+    resource.read(0, expected.size(), reinterpret_cast<std::byte*>(expected.data()));
+
+    romfs::set_cache_budget(1);
+    romfs::use_arena(true);
+
+    const std::byte* first;
+    {
+        auto pin = resource.pin();
+        first = pin.data();
+        ASSERT(reinterpret_cast<std::uintptr_t>(first) % alignof(std::max_align_t) == 0, "Arena data should be aligned");
+        ASSERT(pin.string() == expected, "Arena data should be intact");
+    }
+    {
+        auto pin = resource.pin();
+        ASSERT(pin.data() == first, "Evicted data should be decompressed into the same place again");
+        ASSERT(pin.string() == expected, "Arena data should be intact after being evicted");
+    }
+
+    romfs::set_memory_resource(nullptr);
+    romfs::set_cache_budget(0);
+}
+
+// Test: Sizes come from the generated metadata and match the decompressed data
+TEST(compressed_sizes_match_data) {
+    for (auto entry : romfs::walk()) {
+        if (entry.is_directory())
+            continue;
+
+        const auto& resource = entry.resource();
+        auto size = resource.size();
+        ASSERT_EQ(resource.string().size(), size, "string() should cover the whole resource");
+        ASSERT(resource.data()[size] == std::byte(0x00), "Decompressed data should be null terminated");
+    }
+}
+
+// Test: .romfscompress policies decide per resource whether it gets compressed
+TEST(compression_policy) {
+    ASSERT(!romfs::get("binary.bin").compressed(), "binary.bin should be stored as configured in .romfscompress");
+    ASSERT(romfs::get("data.json").compressed(), "data.json should be compressed as configured in .romfscompress");
+#if LIBROMFS_TEST_SOLID_BLOCK_SIZE > 0
+    ASSERT(romfs::get("hello.txt").compressed(), "hello.txt is small enough to be compressed as part of a solid block");
+#else
+    ASSERT(!romfs::get("hello.txt").compressed(), "hello.txt doesn't shrink when compressed and should be stored");
+#endif
+}
+
+// Test: Stored resources are served straight from the embedded data
+TEST(stored_resource_content) {
+    const auto& resource = romfs::get("binary.bin");
+    ASSERT_EQ(resource.string().size(), 25, "Stored content should have the size of its file");
+    ASSERT(resource.string().starts_with("\x89PNG"), "Stored content should match");
+    ASSERT(resource.data()[resource.size()] == std::byte(0x00), "Stored data should be null terminated");
+}
+
 // Test: Compressed nested file
 TEST(compressed_nested_file) {
     auto resource = romfs::get("subdir/nested.txt");
@@ -79,4 +390,141 @@ TEST(compressed_json_file) {
     ASSERT(content.find("\"features\"") != std::string::npos, "JSON features field should be present");
 }
 
+#if LIBROMFS_TEST_SOLID_BLOCK_SIZE > 0
+// Test: Small compressed resources share a solid block and are served from its data
+TEST(solid_block_members) {
+    const auto& json = romfs::get("data.json");
+    const auto& empty = romfs::get("empty.txt");
+
+    auto jsonPin = json.pin();
+    auto emptyPin = empty.pin();
+    ASSERT(jsonPin.data()[json.size()] == std::byte(0x00), "Solid block members should be null terminated");
+
+    // Both are offsets into the same decompressed block, compare them as addresses so this holds for separate allocations too
+    const auto jsonAddress = reinterpret_cast<std::uintptr_t>(jsonPin.data());
+    const auto emptyAddress = reinterpret_cast<std::uintptr_t>(emptyPin.data());
+    ASSERT(std::max(jsonAddress, emptyAddress) - std::min(jsonAddress, emptyAddress) < LIBROMFS_TEST_SOLID_BLOCK_SIZE, "data.json and empty.txt should live in the same block");
+
+    std::byte buffer[8] = { };
+    ASSERT_EQ(json.read(json.size() - sizeof(buffer), sizeof(buffer), buffer), sizeof(buffer), "Range reads should work on solid block members");
+    ASSERT(std::memcmp(buffer, jsonPin.data() + json.size() - sizeof(buffer), sizeof(buffer)) == 0, "Range read should match the block's data");
+
+    auto reader = romfs::open("data.json");
+    std::string streamed;
+    std::byte chunk[16];
+    while (auto bytesRead = reader.read(chunk))
+        streamed.append(reinterpret_cast<const char*>(chunk), bytesRead);
+    ASSERT(streamed == json.string(), "Streamed content should match");
+
+    jsonPin.reset();
+    emptyPin.reset();
+    ASSERT(json.release(), "data.json should have been released");
+    ASSERT(!empty.release(), "Releasing data.json should have released the whole block");
+}
+#endif
+
+// Test: Released data is freed and decompressed again on its next use
+TEST(release_decompressed_data) {
+    const auto& resource = romfs::get("lorem.txt");
+    auto content = std::string(resource.string());
+
+    const auto usedBefore = romfs::cache_usage().used;
+    ASSERT(resource.release(), "lorem.txt should have been released");
+    ASSERT_EQ(romfs::cache_usage().used, usedBefore - resource.size() - 1, "Released data should no longer be accounted for");
+    ASSERT(!resource.release(), "Nothing should be left to release");
+
+    ASSERT(resource.string() == content, "Released data should decompress again");
+}
+
+// Test: Pinned data survives trimming
+TEST(trim_skips_pinned) {
+    const auto& resource = romfs::get("lorem.txt");
+    auto pin = resource.pin();
+
+    ASSERT(!resource.release(), "Pinned data must not be released");
+    romfs::trim("lorem.txt");
+    ASSERT(romfs::get("lorem.txt").pin().data() == pin.data(), "Pinned data should stay in place");
+
+    pin.reset();
+    ASSERT_EQ(romfs::trim([](std::string_view path) { return path == "lorem.txt"; }), resource.size() + 1, "Unpinned data should be trimmed");
+}
+
+// Test: Reading a resource while its data is being released never copies from freed data
+TEST(concurrent_read_release) {
+    const auto& resource = romfs::get("lorem.txt");
+    std::string expected(resource.size(), '\0');
+    resource.read(0, expected.size(), reinterpret_cast<std::byte*>(expected.data()));
+
+    std::atomic<bool> done = false;
+    std::atomic<bool> intact = true;
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < 4; i++) {
+        threads.emplace_back([&, i] {
+            std::vector<std::byte> buffer(resource.uncompressed_size());
+            while (!done) {
+                if (i % 2 == 0)
+                    resource.read(0, buffer.size(), buffer.data());
+                else
+                    resource.decompress_into(buffer);
+
+                if (std::memcmp(buffer.data(), expected.data(), expected.size()) != 0)
+                    intact = false;
+            }
+        });
+    }
+
+    // data() keeps the data around for good, until it gets released again
+    for (std::size_t iteration = 0; iteration < 2000; iteration++) {
+        std::ignore = resource.data();
+        if (iteration % 2 == 0)
+            resource.release();
+        else
+            romfs::trim("lorem.txt");
+    }
+
+    done = true;
+    for (auto& thread : threads)
+        thread.join();
+
+    resource.release();
+    ASSERT(intact, "Every read should see intact data");
+}
+
+// Test: Trimming everything leaves no unpinned data behind
+TEST(trim_everything) {
+    for (auto entry : romfs::walk())
+        if (!entry.is_directory())
+            std::ignore = entry.resource().data();
+
+    ASSERT(romfs::trim() > 0, "Something should have been trimmed");
+    ASSERT_EQ(romfs::cache_usage().used, 0, "Nothing should be left decompressed");
+    ASSERT(romfs::get("data.json").string().find("libromfs") != std::string::npos, "Trimmed data should decompress again");
+}
+
+#if LIBROMFS_COMPRESSION_CODEC == 2
+// Test: The locale files give the trainer enough similar samples to embed a dictionary, and everything decodes through it
+TEST(zstd_dictionary_embedded) {
+    auto dictionary = ROMFS_CONCAT(ROMFS_NAME, _get_dictionary)();
+    ASSERT(dictionary.size() >= 4, "A dictionary should have been embedded");
+
+    const std::uint8_t magic[] = { 0x37, 0xA4, 0x30, 0xEC };
+    ASSERT(std::equal(std::begin(magic), std::end(magic), dictionary.begin()), "Embedded data should be a trained zstd dictionary");
+
+    auto locales = romfs::list("subdir/locale");
+    ASSERT(locales.size() >= 8, "There should be enough locale files to train on");
+    for (const auto& path : locales) {
+        std::ifstream file(std::string(LIBROMFS_TEST_RESOURCE_LOCATION) + "/" + std::string(path), std::ios::binary);
+        ASSERT(file.is_open(), "Source file should be readable");
+        std::string expected(std::istreambuf_iterator<char>(file), {});
+
+        const auto& resource = romfs::get(path);
+        ASSERT(resource.compressed(), "Locale files should be compressed");
+
+        std::string content(resource.size(), '\0');
+        resource.read(0, content.size(), reinterpret_cast<std::byte*>(content.data()));
+        ASSERT(content == expected, "Resources should decode through the dictionary");
+    }
+}
+#endif
+
 #endif // LIBROMFS_COMPRESS_RESOURCES
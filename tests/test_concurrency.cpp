@@ -0,0 +1,82 @@
+#include "test_framework.hpp"
+#include <romfs/romfs.hpp>
+#include <atomic>
+#include <coroutine>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace test;
+
+// Test: Concurrent first access to a resource decompresses it exactly once
+TEST(concurrent_first_access) {
+    const auto& resource = romfs::get("data.json");
+
+    std::atomic<bool> start = false;
+    std::vector<const std::byte*> pointers(8);
+    std::vector<std::size_t> sizes(8);
+    std::vector<std::thread> threads;
+
+    for (std::size_t i = 0; i < pointers.size(); i++) {
+        threads.emplace_back([&, i] {
+            while (!start)
+                std::this_thread::yield();
+
+            pointers[i] = resource.data();
+            sizes[i] = resource.size();
+        });
+    }
+
+    start = true;
+    for (auto& thread : threads)
+        thread.join();
+
+    for (std::size_t i = 0; i < pointers.size(); i++) {
+        ASSERT(pointers[i] == pointers[0], "Every thread should see the same data");
+        ASSERT_EQ(sizes[i], sizes[0], "Every thread should see the same size");
+    }
+    ASSERT(resource.string().find("libromfs") != std::string::npos, "Data should be intact after concurrent access");
+}
+
+// Test: Copies of a resource share its decompressed data
+TEST(resource_copies_share_data) {
+    auto copy = romfs::get("hello.txt");
+    ASSERT(copy.data() == romfs::get("hello.txt").data(), "Copies should share the same data");
+}
+
+namespace {
+
+    // Minimal coroutine that starts right away and fulfills a promise with its result
+    struct Task {
+        struct promise_type {
+            Task get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    Task read_async(std::string_view path, std::promise<std::string> &result) {
+        auto pin = co_await romfs::get_async(path);
+        result.set_value(std::string(pin.string()));
+    }
+
+}
+
+// Test: Awaiting a resource from a coroutine
+TEST(coroutine_get_async) {
+    std::promise<std::string> result;
+    auto future = result.get_future();
+    read_async("data.json", result);
+
+    ASSERT(future.get() == romfs::get("data.json").string(), "Awaited content should match");
+}
+
+// Test: Waiting for an asynchronous resource
+TEST(future_get_async) {
+    auto pending = romfs::get_async("subdir/nested.txt");
+    auto pin = pending.get();
+    ASSERT(pending.ready(), "Resource should be ready once get() returned");
+    ASSERT(pin.string().find("subdirectory") != std::string::npos, "Content should match");
+}